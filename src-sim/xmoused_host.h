@@ -0,0 +1,145 @@
+/*
+ * XMouseD host build - Amiga types and HAL for the simulator
+ *
+ * Included by src/xmoused.c when XMOUSED_HOST is defined, instead of
+ * the NDK headers. Only what the polling core uses is declared here.
+ * HAL functions are implemented by the simulator (xmsim.c).
+ */
+
+#ifndef XMOUSED_HOST_H
+#define XMOUSED_HOST_H
+
+#include <stddef.h>
+
+//===========================================================================
+// Amiga Types
+//===========================================================================
+
+typedef unsigned char   UBYTE;
+typedef signed char     BYTE;
+typedef unsigned short  UWORD;
+typedef signed short    WORD;
+typedef unsigned int    ULONG;  // 32 bits on ILP32 and LP64 hosts
+typedef signed int      LONG;
+typedef short           BOOL;
+typedef void *          APTR;
+typedef long            BPTR;
+
+#ifndef TRUE
+#define TRUE    1
+#define FALSE   0
+#endif
+
+//===========================================================================
+// Exec / Devices (minimal layouts, host only)
+//===========================================================================
+
+struct Task;
+struct Device;
+struct Unit;
+struct ExecBase;
+struct DosLibrary;
+
+struct Message
+{
+    struct MsgPort *mn_ReplyPort;
+    UWORD mn_Length;
+};
+
+struct MsgPort
+{
+    ULONG mp_SigBit;
+};
+
+struct Interrupt
+{
+    APTR is_Data;
+    void (*is_Code)(void);
+};
+
+struct IORequest
+{
+    struct Message io_Message;
+    struct Device *io_Device;
+    struct Unit *io_Unit;
+    UWORD io_Command;
+    UBYTE io_Flags;
+    BYTE io_Error;
+};
+
+struct IOStdReq
+{
+    struct Message io_Message;
+    struct Device *io_Device;
+    struct Unit *io_Unit;
+    UWORD io_Command;
+    UBYTE io_Flags;
+    BYTE io_Error;
+    ULONG io_Actual;
+    ULONG io_Length;
+    APTR io_Data;
+    ULONG io_Offset;
+};
+
+struct timeval
+{
+    ULONG tv_secs;
+    ULONG tv_micro;
+};
+
+struct timerequest
+{
+    struct IORequest tr_node;
+    struct timeval tr_time;
+};
+
+struct EClockVal
+{
+    ULONG ev_hi;
+    ULONG ev_lo;
+};
+
+struct InputEvent
+{
+    struct InputEvent *ie_NextEvent;
+    UBYTE ie_Class;
+    UBYTE ie_SubClass;
+    UWORD ie_Code;
+    UWORD ie_Qualifier;
+    WORD ie_X;
+    WORD ie_Y;
+    struct timeval ie_TimeStamp;
+};
+
+#define CMD_NONSTD          9
+#define IND_WRITEEVENT      (CMD_NONSTD + 2)
+#define TR_ADDREQUEST       CMD_NONSTD
+
+#define UNIT_MICROHZ        0
+#define UNIT_VBLANK         1
+#define UNIT_ECLOCK         2
+#define UNIT_WAITUNTIL      3
+#define UNIT_WAITECLOCK     4
+
+#define IECLASS_RAWKEY      0x01
+#define IECLASS_NEWMOUSE    0x16
+#define IECODE_UP_PREFIX    0x80
+
+#define NM_WHEEL_UP         0x7A
+#define NM_WHEEL_DOWN       0x7B
+#define NM_BUTTON_FOURTH    0x7E
+
+//===========================================================================
+// HAL (implemented by the simulator)
+//===========================================================================
+
+UWORD HAL_ReadRegister(void);
+ULONG HAL_ReadClock(struct EClockVal *ev);
+void  HAL_TimerSend(struct timerequest *req);
+UWORD HAL_PeekQualifier(void);
+void  HAL_InjectSync(struct IOStdReq *req);
+void  HAL_InjectAsync(struct IOStdReq *req);
+struct IORequest *HAL_InjectReaped(struct MsgPort *port);
+void  HAL_InjectWait(struct IOStdReq *req);
+
+#endif // XMOUSED_HOST_H
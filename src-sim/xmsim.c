@@ -0,0 +1,1285 @@
+/*
+ * XMSim - Host simulator for the XMouseD polling core
+ *
+ * Builds src/xmoused.c with XMOUSED_HOST on Linux/macOS (gcc/clang) and
+ * runs the tick, injection, timer and adaptive code against a simulated
+ * clock, SAGA register and timer.device. Time is virtual: runs are fast
+ * and deterministic, so wakeups and latency can be compared per change.
+ *
+ * Usage: xmsim [0xCONFIG] [0xOPTIONS] [SECONDS]
+ *        xmsim REPLAY <file> [0xCONFIG] [0xOPTIONS] [VERBOSE]
+ *        xmsim BENCH [0xOPTIONS] [SECONDS]
+ *        xmsim LADDER [TICKS]
+ *        xmsim TICKS [SECONDS]
+ *        xmsim PROFILE idle active burst dec inc grace idle-th curve [0xOPTIONS] [SECONDS]
+ *
+ * (c) 2025 Vincent Buzzano
+ * Licensed under MIT License
+ */
+
+#define XMOUSED_HOST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "xmoused_host.h"
+#include "../src/xmoused.c"
+
+//===========================================================================
+// Simulator Constants
+//===========================================================================
+
+#define SIM_ECLOCK_FREQ     709379      // PAL EClock (Hz)
+#define SIM_FRAME_US        20000       // PAL frame (UNIT_VBLANK resolution)
+#define SIM_DEFAULT_SECONDS 60
+#define SIM_LATENCY_MAX     8192        // Latency samples kept for percentiles
+
+typedef unsigned long long SimTime;     // Virtual time (microseconds)
+
+//===========================================================================
+// Simulated Hardware
+//===========================================================================
+
+static SimTime s_simNow;                // Current virtual time
+static SimTime s_simFireAt;             // Pending timer completion
+static BOOL s_simTimerPending;
+
+static BYTE s_simWheel;                 // SAGA wheel counter
+static UWORD s_simButtons;              // SAGA button bits (8-9)
+
+static struct timerequest s_simTimerReq;
+static struct IOStdReq s_simInputReq[INJECT_RING_SIZE];
+static struct IORequest *s_simReaped[INJECT_RING_SIZE]; // Completed async requests
+static UBYTE s_simReapedCount;
+
+// Latency: time of the oldest change not yet injected (0 = none)
+static SimTime s_simWheelSince;
+static SimTime s_simButtonSince;
+
+typedef struct
+{
+    ULONG count;
+    SimTime sumUs;
+    SimTime maxUs;
+} SimLatency;
+
+typedef struct
+{
+    ULONG wakeups;              // Timer completions
+    ULONG activeTicks;          // Ticks that injected events
+    ULONG submits;              // IND_WRITEEVENT requests
+    ULONG events;               // Input events injected
+    ULONG wheelEvents;
+    ULONG buttonEvents;
+    ULONG missedButtons;        // Button changes undone before a tick saw them
+    SimLatency wheel;           // Change to injection, wheel
+    SimLatency buttons;         // Change to injection, buttons
+    SimTime stateUs[4];         // Time spent per POLL_STATE_*
+    ULONG latencyCount;         // Samples in latencyUs (both classes)
+    ULONG latencyUs[SIM_LATENCY_MAX];
+} SimReport;
+
+static SimReport s_simReport;
+static SimTime s_simLastWake;           // Time of the previous wakeup
+static UBYTE s_simState;                // Adaptive state since s_simLastWake
+static BOOL s_simVerbose;              // Print every latency sample (REPLAY VERBOSE)
+static volatile unsigned long long s_simSink;  // Results of timed loops (not optimized out)
+
+//===========================================================================
+// HAL Implementation
+//===========================================================================
+
+/**
+ * Convert virtual time to a 64-bit EClock value.
+ */
+static void sim_ToEClock(SimTime us, struct EClockVal *ev)
+{
+    unsigned long long ticks = us * SIM_ECLOCK_FREQ / 1000000;
+
+    ev->ev_hi = (ULONG)(ticks >> 32);
+    ev->ev_lo = (ULONG)ticks;
+}
+
+/**
+ * Convert EClock ticks to virtual time.
+ */
+static SimTime sim_FromEClock(unsigned long long ticks)
+{
+    return ticks * 1000000 / SIM_ECLOCK_FREQ;
+}
+
+UWORD HAL_ReadRegister(void)
+{
+    return s_simButtons | (UBYTE)s_simWheel;
+}
+
+ULONG HAL_ReadClock(struct EClockVal *ev)
+{
+    sim_ToEClock(s_simNow, ev);
+    return SIM_ECLOCK_FREQ;
+}
+
+/**
+ * Schedule the timer completion like timer.device would for the unit.
+ * UNIT_VBLANK completes on the first frame after the delay.
+ */
+void HAL_TimerSend(struct timerequest *req)
+{
+    unsigned long long value = ((unsigned long long)req->tr_time.tv_secs << 32) | req->tr_time.tv_micro;
+    SimTime delay = (SimTime)req->tr_time.tv_secs * 1000000 + req->tr_time.tv_micro;
+
+    switch (s_timerUnit)
+    {
+        case TIMER_UNIT_VBLANK:
+            s_simFireAt = (s_simNow + delay + SIM_FRAME_US - 1) / SIM_FRAME_US * SIM_FRAME_US;
+            break;
+
+        case TIMER_UNIT_ECLOCK:
+            s_simFireAt = s_simNow + sim_FromEClock(value);
+            break;
+
+        case TIMER_UNIT_WAITECLOCK:
+            s_simFireAt = sim_FromEClock(value);
+            if (s_simFireAt < s_simNow)
+            {
+                s_simFireAt = s_simNow;
+            }
+            break;
+
+        default:
+            s_simFireAt = s_simNow + delay;
+            break;
+    }
+
+    s_simTimerPending = TRUE;
+}
+
+UWORD HAL_PeekQualifier(void)
+{
+    return 0;
+}
+
+/**
+ * Account one latency sample.
+ */
+static void sim_Latency(const char *name, SimLatency *lat, SimTime *since)
+{
+    SimTime us;
+
+    if (!*since) return;
+
+    us = s_simNow - (*since - 1);
+    if (s_simVerbose)
+    {
+        printf("  %10.3fs %-8s %6lluus\n", (double)(*since - 1) / 1000000.0, name, us);
+    }
+    if (s_simReport.latencyCount < SIM_LATENCY_MAX)
+    {
+        s_simReport.latencyUs[s_simReport.latencyCount++] = (ULONG)us;
+    }
+    lat->count++;
+    lat->sumUs += us;
+    if (us > lat->maxUs)
+    {
+        lat->maxUs = us;
+    }
+    *since = 0;
+}
+
+/**
+ * input.device stand-in: count the chain, close latency windows.
+ */
+static void sim_Inject(struct IOStdReq *req)
+{
+    struct InputEvent *ev;
+    BOOL wheel = FALSE, buttons = FALSE;
+
+    s_simReport.submits++;
+
+    for (ev = (struct InputEvent *)req->io_Data; ev; ev = ev->ie_NextEvent)
+    {
+        UWORD code = ev->ie_Code & ~IECODE_UP_PREFIX;
+
+        s_simReport.events++;
+        if (code == NM_WHEEL_UP || code == NM_WHEEL_DOWN)
+        {
+            s_simReport.wheelEvents++;
+            wheel = TRUE;
+        }
+        else
+        {
+            s_simReport.buttonEvents++;
+            buttons = TRUE;
+        }
+    }
+
+    if (wheel) sim_Latency("wheel", &s_simReport.wheel, &s_simWheelSince);
+    if (buttons) sim_Latency("buttons", &s_simReport.buttons, &s_simButtonSince);
+}
+
+void HAL_InjectSync(struct IOStdReq *req)
+{
+    sim_Inject(req);
+}
+
+void HAL_InjectAsync(struct IOStdReq *req)
+{
+    // Completes at once: reply is collected by injectReap()
+    sim_Inject(req);
+    s_simReaped[s_simReapedCount++] = (struct IORequest *)req;
+}
+
+struct IORequest *HAL_InjectReaped(struct MsgPort *port)
+{
+    UBYTE i;
+    struct IORequest *io;
+
+    (void)port;
+    if (!s_simReapedCount) return NULL;
+
+    io = s_simReaped[0];
+    for (i = 1; i < s_simReapedCount; i++)
+    {
+        s_simReaped[i - 1] = s_simReaped[i];
+    }
+    s_simReapedCount--;
+    return io;
+}
+
+void HAL_InjectWait(struct IOStdReq *req)
+{
+    UBYTE i;
+
+    for (i = 0; i < s_simReapedCount; i++)
+    {
+        if (s_simReaped[i] == (struct IORequest *)req)
+        {
+            s_simReaped[i] = s_simReaped[--s_simReapedCount];
+            break;
+        }
+    }
+}
+
+//===========================================================================
+// Workload
+//===========================================================================
+
+// One step: wait, then move the wheel and/or set the button bits
+typedef struct
+{
+    ULONG delayUs;              // Wait before this step
+    BYTE wheel;                 // Detents to add to the wheel counter
+    UWORD buttons;              // New SAGA button bits
+} SimStep;
+
+typedef struct
+{
+    const SimStep *steps;
+    ULONG count;
+    BOOL loop;                  // Restart from the first step when done
+} SimWorkload;
+
+// Desktop session, repeated: scroll, click, flick, hold
+static const SimStep s_simDemo[] =
+{
+    { 1000000, 0, 0 },
+    {   40000, 1, 0 }, { 40000, 1, 0 }, { 40000, 1, 0 }, { 40000, 1, 0 }, { 40000, 1, 0 },
+    {  800000, 0, SAGA_BUTTON4_MASK },
+    {  110000, 0, 0 },
+    { 2000000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 },
+    {    8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 }, { 8000, -1, 0 },
+    { 1500000, 0, SAGA_BUTTON5_MASK },
+    {  600000, 0, 0 },
+    { 3000000, 0, 0 }
+};
+
+static const SimWorkload s_simDemoWorkload =
+{
+    s_simDemo, sizeof(s_simDemo) / sizeof(s_simDemo[0]), TRUE
+};
+
+//===========================================================================
+// Benchmark Workloads
+//===========================================================================
+
+// Idle desktop: no input at all
+static const SimStep s_simIdle[] =
+{
+    { 10000000, 0, 0 }
+};
+
+// Sporadic single clicks (button 4, ~90ms press), irregular gaps
+static const SimStep s_simClicks[] =
+{
+    { 1703100, 0, SAGA_BUTTON4_MASK }, { 90000, 0, 0 },
+    { 3108700, 0, SAGA_BUTTON4_MASK }, { 80000, 0, 0 },
+    { 2301900, 0, SAGA_BUTTON4_MASK }, { 110000, 0, 0 },
+    { 4907300, 0, SAGA_BUTTON4_MASK }, { 95000, 0, 0 }
+};
+
+// Continuous scrolling: a detent every 63ms for 3s, 1s pause
+#define SIM_SCROLL_STEP { 63000, 1, 0 }
+static const SimStep s_simScroll[] =
+{
+    { 1007300, 1, 0 },
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP,
+    SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP, SIM_SCROLL_STEP
+};
+
+// Flick bursts: 12 detents 6ms apart, then a pause
+#define SIM_FLICK_STEP(dir) { 6000, dir, 0 }
+static const SimStep s_simFlicks[] =
+{
+    { 1203700, -1, 0 },
+    SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1),
+    SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1),
+    SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1), SIM_FLICK_STEP(-1),
+    { 2506100, 1, 0 },
+    SIM_FLICK_STEP(1), SIM_FLICK_STEP(1), SIM_FLICK_STEP(1), SIM_FLICK_STEP(1),
+    SIM_FLICK_STEP(1), SIM_FLICK_STEP(1), SIM_FLICK_STEP(1), SIM_FLICK_STEP(1),
+    SIM_FLICK_STEP(1), SIM_FLICK_STEP(1), SIM_FLICK_STEP(1)
+};
+
+// Button holds (button 5, 1.5s), e.g. drag or browser back held
+static const SimStep s_simHolds[] =
+{
+    { 2004700, 0, SAGA_BUTTON5_MASK }, { 1503300, 0, 0 },
+    { 3002900, 0, SAGA_BUTTON5_MASK }, { 801700, 0, 0 }
+};
+
+#define SIM_WORKLOAD(steps) { steps, sizeof(steps) / sizeof(steps[0]), TRUE }
+
+static const struct
+{
+    const char *name;
+    SimWorkload workload;
+} s_simBenchWorkloads[] =
+{
+    { "idle",   SIM_WORKLOAD(s_simIdle) },
+    { "clicks", SIM_WORKLOAD(s_simClicks) },
+    { "scroll", SIM_WORKLOAD(s_simScroll) },
+    { "flicks", SIM_WORKLOAD(s_simFlicks) },
+    { "holds",  SIM_WORKLOAD(s_simHolds) }
+};
+
+#define SIM_BENCH_WORKLOADS (sizeof(s_simBenchWorkloads) / sizeof(s_simBenchWorkloads[0]))
+
+/**
+ * Apply a workload step to the register model.
+ */
+static void sim_ApplyStep(const SimStep *step)
+{
+    if (step->wheel)
+    {
+        s_simWheel = (BYTE)(s_simWheel + step->wheel);
+        if (!s_simWheelSince) s_simWheelSince = s_simNow + 1;
+    }
+    if (step->buttons != s_simButtons)
+    {
+        s_simButtons = step->buttons;
+        if (!s_simButtonSince) s_simButtonSince = s_simNow + 1;
+    }
+}
+
+//===========================================================================
+// Trace Replay
+//===========================================================================
+
+// Traces written by the daemon (OPT_TRACE_CAPTURE) are big-endian,
+// TraceHeader then TraceRecord[count] as laid out by the 68k build.
+#define SIM_TRACE_HEADER_SIZE   30          // v1: 28, no source field
+#define SIM_TRACE_RECORD_SIZE   8
+#define SIM_REPLAY_TAIL_US      2000000     // Keep running after the last sample
+
+typedef struct
+{
+    TraceHeader header;
+    ULONG submits;              // TRACE_INJECT records
+    ULONG events;               // Events in captured submissions
+    SimTime durationUs;         // First to last record
+} SimCapture;
+
+static ULONG sim_BE32(const UBYTE *p)
+{
+    return ((ULONG)p[0] << 24) | ((ULONG)p[1] << 16) | ((ULONG)p[2] << 8) | p[3];
+}
+
+static UWORD sim_BE16(const UBYTE *p)
+{
+    return (UWORD)((p[0] << 8) | p[1]);
+}
+
+/**
+ * Load a trace and convert its samples into workload steps.
+ * The first sample sets the initial register state.
+ * @return Steps (malloc'd), NULL on error
+ */
+static SimStep *sim_LoadTrace(const char *path, SimWorkload *wl, SimCapture *cap)
+{
+    UBYTE buf[SIM_TRACE_HEADER_SIZE];
+    TraceHeader *hdr = &cap->header;
+    SimStep *steps;
+    FILE *f;
+    ULONG i, n = 0;
+    ULONG firstClock = 0, lastClock = 0, stepClock = 0;
+    UWORD last = 0;
+    BOOL first = TRUE;
+
+    f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "xmsim: cannot open %s\n", path);
+        return NULL;
+    }
+
+    if (fread(buf, 1, SIM_TRACE_HEADER_SIZE - 2, f) != SIM_TRACE_HEADER_SIZE - 2 ||
+        sim_BE32(buf) != TRACE_MAGIC || sim_BE16(buf + 4) < 1 || sim_BE16(buf + 4) > TRACE_VERSION ||
+        (sim_BE16(buf + 4) >= 2 && fread(buf + SIM_TRACE_HEADER_SIZE - 2, 1, 2, f) != 2))
+    {
+        fprintf(stderr, "xmsim: %s is not a v1-v%d trace\n", path, TRACE_VERSION);
+        fclose(f);
+        return NULL;
+    }
+
+    memset(cap, 0, sizeof(*cap));
+    hdr->magic = sim_BE32(buf);
+    hdr->version = sim_BE16(buf + 4);
+    hdr->config = buf[6];
+    hdr->timerUnit = buf[7];
+    hdr->options = sim_BE32(buf + 8);
+    hdr->eclockFreq = sim_BE32(buf + 12);
+    hdr->ticks = sim_BE32(buf + 16);
+    hdr->count = sim_BE32(buf + 20);
+    hdr->dropped = sim_BE32(buf + 24);
+    hdr->source = (hdr->version >= 2) ? sim_BE16(buf + 28) : TRACE_SOURCE_TIMER;  // v1: unknown, assume poll time
+
+    if (hdr->eclockFreq == 0 || hdr->count > TRACE_RECORDS_MAX)
+    {
+        fprintf(stderr, "xmsim: %s has a corrupt header\n", path);
+        fclose(f);
+        return NULL;
+    }
+
+    steps = (SimStep *)calloc(hdr->count ? hdr->count : 1, sizeof(SimStep));
+    if (!steps)
+    {
+        fclose(f);
+        return NULL;
+    }
+
+    for (i = 0; i < hdr->count; i++)
+    {
+        UBYTE rec[SIM_TRACE_RECORD_SIZE];
+        ULONG clock;
+        UWORD value;
+
+        if (fread(rec, 1, SIM_TRACE_RECORD_SIZE, f) != SIM_TRACE_RECORD_SIZE)
+        {
+            fprintf(stderr, "xmsim: %s truncated at record %lu\n", path, (unsigned long)i);
+            break;
+        }
+        clock = sim_BE32(rec);
+        value = sim_BE16(rec + 4);
+
+        if (i == 0) firstClock = clock;
+        lastClock = clock;
+
+        if (sim_BE16(rec + 6) == TRACE_INJECT)
+        {
+            cap->submits++;
+            cap->events += value;
+            continue;
+        }
+
+        if (first)
+        {
+            // Initial state, not an input change
+            s_simWheel = (BYTE)(value & SAGA_WHEEL_MASK);
+            s_simButtons = value & SAGA_BUTTONS_MASK;
+            stepClock = clock;
+            first = FALSE;
+        }
+        else
+        {
+            // Clock differences wrap with the 32-bit EClock
+            steps[n].delayUs = (ULONG)((unsigned long long)(clock - stepClock) * 1000000 / hdr->eclockFreq);
+            steps[n].wheel = (BYTE)((BYTE)(value & SAGA_WHEEL_MASK) - (BYTE)(last & SAGA_WHEEL_MASK));
+            steps[n].buttons = value & SAGA_BUTTONS_MASK;
+            stepClock = clock;
+            n++;
+        }
+        last = value;
+    }
+    fclose(f);
+
+    cap->durationUs = (unsigned long long)(lastClock - firstClock) * 1000000 / hdr->eclockFreq;
+    wl->steps = steps;
+    wl->count = n;
+    wl->loop = FALSE;
+    return steps;
+}
+
+//===========================================================================
+// Simulation
+//===========================================================================
+
+/**
+ * Reset the simulator and the core state a fresh daemon starts with.
+ */
+static void sim_Reset(void)
+{
+    s_simNow = 0;
+    s_simFireAt = 0;
+    s_simTimerPending = FALSE;
+    s_simWheel = 0;
+    s_simButtons = 0;
+    s_simReapedCount = 0;
+    s_simWheelSince = 0;
+    s_simButtonSince = 0;
+    s_simLastWake = 0;
+    memset(&s_simReport, 0, sizeof(s_simReport));
+    memset(&s_shared.stats, 0, sizeof(s_shared.stats));
+
+    memset(s_timerStats, 0, sizeof(s_timerStats));
+    memset(&s_timerDeadline, 0, sizeof(s_timerDeadline));
+    s_timerSkipped = 0;
+    s_timerRequested = 0;
+    s_timerStartClock = 0;
+    s_timerFireClock = 0;
+
+    memset(s_injectRing, 0, sizeof(s_injectRing));
+    s_injectSlot = NULL;
+    s_injectNext = 0;
+    s_pendingWheel = 0;
+    s_pendingButtonCount = 0;
+
+    memset(s_accelSlices, 0, sizeof(s_accelSlices));
+    s_accelSlice = 0;
+    s_accelSliceStart = 0;
+    s_accelSum = 0;
+    s_accelDir = 0;
+    s_accelFrac = 0;
+}
+
+/**
+ * Bring up the polling core like daemon_Init() does.
+ * Register model (s_simWheel/s_simButtons) must be set before.
+ */
+static void sim_Init(UBYTE config, ULONG options)
+{
+    MouseSample sample;
+    UBYTE i;
+
+    s_TimerReq = &s_simTimerReq;
+    s_InputReq = &s_simInputReq[0];
+    for (i = 0; i < INJECT_RING_SIZE; i++)
+    {
+        s_injectRing[i].req = &s_simInputReq[i];
+    }
+
+    s_configByte = config & ~CONFIG_DEBUG_MODE;
+    s_options = options & ~(OPT_VBL_SAMPLING | OPT_TRACE_CAPTURE);   // Timer path only
+    s_timerUnit = (UBYTE)((s_options & OPT_TIMER_UNIT_MASK) >> OPT_TIMER_UNIT_SHIFT);
+    daemon_ClockInit(SIM_ECLOCK_FREQ);
+
+    daemon_DecodeSample(HAL_ReadRegister(), &sample);
+    s_lastBTState = sample.buttons;
+    s_lastWHCounter = sample.wheel;
+    s_lastWHDelta = 0;
+
+    daemon_ApplyMode();
+    s_simState = s_adaptiveState;
+    daemon_TimerStart(s_pollInterval);
+}
+
+/**
+ * Run the workload until the end time, dispatching timer completions.
+ */
+static void sim_Run(const SimWorkload *wl, SimTime endUs)
+{
+    SimTime stepAt = wl->count ? wl->steps[0].delayUs : (SimTime)-1;
+    ULONG step = 0;
+
+    while (s_simNow < endUs)
+    {
+        // Next event: workload step or timer completion
+        if (stepAt <= s_simFireAt || !s_simTimerPending)
+        {
+            if (stepAt > endUs) break;
+
+            s_simNow = stepAt;
+            sim_ApplyStep(&wl->steps[step]);
+            if (++step == wl->count)
+            {
+                if (!wl->loop)
+                {
+                    stepAt = (SimTime)-1;
+                    continue;
+                }
+                step = 0;
+            }
+            stepAt += wl->steps[step].delayUs;
+            continue;
+        }
+
+        s_simNow = s_simFireAt;
+        s_simTimerPending = FALSE;
+        s_simReport.wakeups++;
+        s_simReport.stateUs[s_simState] += s_simNow - s_simLastWake;
+        s_simLastWake = s_simNow;
+
+        {
+            ULONG submits = s_simReport.submits;
+
+            s_tickHandler();
+            if (s_simReapedCount)
+            {
+                injectReap();
+            }
+            if (s_simReport.submits != submits)
+            {
+                s_simReport.activeTicks++;
+            }
+        }
+        
+        // Change still pending after a tick: the button went back before it was read
+        if (s_simButtonSince && (s_configByte & CONFIG_BUTTONS_ENABLED))
+        {
+            s_simReport.missedButtons++;
+            s_simButtonSince = 0;
+        }
+        s_simState = s_adaptiveState;
+    }
+
+    s_simReport.stateUs[s_simState] += s_simNow - s_simLastWake;
+    s_simLastWake = s_simNow;
+}
+
+/**
+ * Print one latency line.
+ */
+static void sim_PrintLatency(const char *name, const SimLatency *lat)
+{
+    if (!lat->count)
+    {
+        printf("  %-8s latency: no samples\n", name);
+        return;
+    }
+    printf("  %-8s latency: mean %6lluus, max %6lluus (%lu samples)\n", name,
+           lat->sumUs / lat->count, lat->maxUs, (unsigned long)lat->count);
+}
+
+/**
+ * Polling engine name of a config byte.
+ */
+static const char *sim_EngineName(UBYTE config)
+{
+    switch (TICK_ENGINE(config))
+    {
+        case CONFIG_FIXED_MODE: return "fixed";
+        case CONFIG_PREDICTIVE: return ENGINE_NAME_PREDICTIVE;
+    }
+    return ENGINE_NAME_LADDER;
+}
+
+/**
+ * Print the report of a run.
+ */
+static void sim_PrintReport(const char *source)
+{
+    double duration = (double)s_simNow / 1000000.0;
+
+    if (duration <= 0) duration = 1;
+
+    printf("XMSim: %s, config 0x%02x (%s %s), options 0x%08x, timer %s, %.1fs\n",
+           source, s_configByte,
+           (s_configByte & CONFIG_FIXED_MODE) ? s_activeMode->normalName : s_activeMode->adaptiveName,
+           sim_EngineName(s_configByte),
+           s_options, s_timerUnitNames[s_timerUnit], duration);
+    printf("  wakeups:         %lu (%.1f/s), %lu with events\n",
+           (unsigned long)s_simReport.wakeups, s_simReport.wakeups / duration,
+           (unsigned long)s_simReport.activeTicks);
+    printf("  submits:         %lu\n", (unsigned long)s_simReport.submits);
+    printf("  events:          %lu (wheel %lu, buttons %lu)\n",
+           (unsigned long)s_simReport.events,
+           (unsigned long)s_simReport.wheelEvents, (unsigned long)s_simReport.buttonEvents);
+    sim_PrintLatency("wheel", &s_simReport.wheel);
+    sim_PrintLatency("buttons", &s_simReport.buttons);
+    printf("  missed buttons:  %lu\n", (unsigned long)s_simReport.missedButtons);
+    printf("  core stats:      %lu ticks, %lu submits, events wheel %lu buttons %lu, max wheel delta %lu\n",
+           (unsigned long)s_shared.stats.ticks, (unsigned long)s_shared.stats.submits,
+           (unsigned long)s_shared.stats.events[STATS_CLASS_WHEEL], (unsigned long)s_shared.stats.events[STATS_CLASS_BUTTONS],
+           (unsigned long)s_shared.stats.maxWheelDelta);
+    printf("  timer achieved:  %luus mean (%lu samples)\n",
+           (unsigned long)daemon_TimerAchievedUs(s_timerUnit),
+           (unsigned long)s_timerStats[s_timerUnit].count);
+}
+
+/**
+ * Parse a decimal or 0x-prefixed hex argument.
+ */
+static ULONG sim_ParseArg(const char *arg)
+{
+    return (ULONG)strtoul(arg, NULL, 0);
+}
+
+/**
+ * Case-insensitive keyword match (AmigaDOS style arguments).
+ */
+static BOOL sim_Keyword(const char *arg, const char *keyword)
+{
+    while (*arg && toupper((unsigned char)*arg) == *keyword)
+    {
+        arg++;
+        keyword++;
+    }
+    return *arg == 0 && *keyword == 0;
+}
+
+/**
+ * REPLAY mode: feed a captured trace through the core.
+ * Config and options default to the ones active during capture.
+ */
+static int sim_Replay(int argc, char **argv)
+{
+    SimWorkload wl;
+    SimCapture cap;
+    SimStep *steps;
+    UBYTE config;
+    ULONG options;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: xmsim REPLAY <file> [0xCONFIG] [0xOPTIONS] [VERBOSE]\n");
+        return 1;
+    }
+
+    sim_Reset();
+    steps = sim_LoadTrace(argv[2], &wl, &cap);
+    if (!steps) return 1;
+
+    config = cap.header.config;
+    options = cap.header.options;
+    if (argc > 3 && !sim_Keyword(argv[3], "VERBOSE")) config = (UBYTE)sim_ParseArg(argv[3]);
+    if (argc > 4 && !sim_Keyword(argv[4], "VERBOSE")) options = sim_ParseArg(argv[4]);
+    s_simVerbose = sim_Keyword(argv[argc - 1], "VERBOSE");
+
+    sim_Init(config, options);
+    sim_Run(&wl, cap.durationUs + SIM_REPLAY_TAIL_US);
+    sim_PrintReport(argv[2]);
+
+    printf("  captured:        config 0x%02x, options 0x%08lx, timer %s, %.1fs\n",
+           cap.header.config, (unsigned long)cap.header.options,
+           s_timerUnitNames[cap.header.timerUnit % TIMER_UNIT_COUNT],
+           (double)cap.durationUs / 1000000.0);
+    printf("                   %lu wakeups, %lu submits, %lu events, %lu records (%lu dropped)\n",
+           (unsigned long)cap.header.ticks, (unsigned long)cap.submits, (unsigned long)cap.events,
+           (unsigned long)cap.header.count, (unsigned long)cap.header.dropped);
+    if (cap.header.source == TRACE_SOURCE_TIMER)
+    {
+        printf("  warning:         sampled at poll time, input onsets rounded to the capture's interval\n");
+    }
+
+    free(steps);
+    return 0;
+}
+
+//===========================================================================
+// Adaptive Reference (switch-based state machine, before ladders)
+//===========================================================================
+
+#define SIM_LADDER_TICKS    2000000     // Ticks per profile (LADDER)
+
+typedef struct
+{
+    UBYTE state;
+    ULONG interval;
+    ULONG inactive;
+} SimLegacy;
+
+/**
+ * Previous daemon_GetAdaptiveInterval(): steps, clamps and compares
+ * computed every tick. Kept as reference for LADDER.
+ */
+static ULONG sim_LegacyInterval(SimLegacy *lg, const AdaptiveMode *mode, BOOL hadActivity)
+{
+    if (hadActivity)
+    {
+        lg->inactive = 0;
+    }
+    else
+    {
+        lg->inactive += lg->interval;
+    }
+
+    switch (lg->state)
+    {
+        case POLL_STATE_IDLE:
+            if (hadActivity)
+            {
+                lg->state = POLL_STATE_ACTIVE;
+                lg->interval = mode->activeUs;
+            }
+            break;
+
+        case POLL_STATE_ACTIVE:
+            if (hadActivity)
+            {
+                if (lg->interval > mode->burstUs)
+                {
+                    lg->interval = (lg->interval > mode->stepDecUs) ? (lg->interval - mode->stepDecUs) : mode->burstUs;
+                }
+                if (lg->interval <= mode->burstUs)
+                {
+                    lg->state = POLL_STATE_BURST;
+                    lg->interval = mode->burstUs;
+                }
+            }
+            else if (lg->inactive >= mode->activeThreshold)
+            {
+                lg->state = POLL_STATE_TO_IDLE;
+            }
+            break;
+
+        case POLL_STATE_BURST:
+            if (!hadActivity && lg->inactive >= mode->idleThreshold)
+            {
+                lg->state = POLL_STATE_TO_IDLE;
+            }
+            break;
+
+        case POLL_STATE_TO_IDLE:
+            if (hadActivity)
+            {
+                if (lg->interval > mode->activeUs)
+                {
+                    lg->interval = mode->activeUs;
+                }
+                lg->state = POLL_STATE_ACTIVE;
+            }
+            else
+            {
+                if (lg->interval < mode->idleUs)
+                {
+                    lg->interval += mode->stepIncUs;
+                    if (lg->interval > mode->idleUs)
+                    {
+                        lg->interval = mode->idleUs;
+                    }
+                }
+                if (lg->interval >= mode->idleUs)
+                {
+                    lg->state = POLL_STATE_IDLE;
+                    lg->interval = mode->idleUs;
+                }
+            }
+            break;
+    }
+
+    return lg->interval;
+}
+
+/**
+ * Activity pattern: pauses of 0-400 ticks, then bursts of 1-80 ticks
+ * with activity on ~70% of them. Deterministic (LCG).
+ */
+static void sim_ActivityPattern(UBYTE *activity, ULONG ticks)
+{
+    ULONG seed = 0x584D5452;
+    ULONG i = 0;
+
+    while (i < ticks)
+    {
+        ULONG pause, burst;
+
+        seed = seed * 1103515245 + 12345;
+        pause = (seed >> 16) % 401;
+        seed = seed * 1103515245 + 12345;
+        burst = (seed >> 16) % 80 + 1;
+
+        while (pause-- && i < ticks) activity[i++] = 0;
+        while (burst-- && i < ticks)
+        {
+            seed = seed * 1103515245 + 12345;
+            activity[i++] = ((seed >> 16) % 10) < 7;
+        }
+    }
+}
+
+/**
+ * LADDER mode: ladder state machine against the switch-based reference,
+ * same activity pattern. Reports host time per call and ticks where the
+ * ladder intervals or states differ from the reference (expected: none).
+ */
+static int sim_Ladder(int argc, char **argv)
+{
+    ULONG ticks = (argc > 2) ? sim_ParseArg(argv[2]) : SIM_LADDER_TICKS;
+    UBYTE *activity;
+    ULONG *reference;
+    UBYTE mode;
+
+    if (ticks == 0) ticks = SIM_LADDER_TICKS;
+
+    activity = (UBYTE *)malloc(ticks);
+    reference = (ULONG *)malloc(ticks * sizeof(ULONG));
+    if (!activity || !reference)
+    {
+        free(activity);
+        free(reference);
+        return 1;
+    }
+    sim_ActivityPattern(activity, ticks);
+
+    printf("XMSim LADDER: %lu ticks per profile\n\n", (unsigned long)ticks);
+    printf("%-10s %8s %8s %8s %8s %10s %10s %8s\n", "profile", "switch", "ladder", "entries",
+           "differ", "mean diff", "max diff", "states");
+
+    for (mode = 0; mode < 4; mode++)
+    {
+        const AdaptiveMode *profile = &s_adaptiveModes[mode];
+        SimLegacy lg = { POLL_STATE_IDLE, 0, 0 };
+        UBYTE *states = (UBYTE *)malloc(ticks);
+        ULONG i, differ = 0, stateDiffer = 0, maxDiff = 0;
+        unsigned long long sumDiff = 0, sumUs = 0;
+        clock_t t0, t1, t2, t3;
+
+        if (!states) break;
+
+        // Reference
+        lg.interval = profile->idleUs;
+        t0 = clock();
+        for (i = 0; i < ticks; i++)
+        {
+            reference[i] = sim_LegacyInterval(&lg, profile, activity[i]);
+            states[i] = lg.state;
+        }
+        t1 = clock();
+
+        // Ladders (built for the profile like a SET_CONFIG would)
+        sim_Reset();
+        s_configByte = CONFIG_FEATURES_MASK | (mode << CONFIG_INTERVAL_SHIFT);
+        daemon_ClockInit(SIM_ECLOCK_FREQ);
+        daemon_ApplyMode();
+        t2 = clock();
+        for (i = 0; i < ticks; i++)
+        {
+            sumUs += daemon_GetAdaptiveInterval(activity[i]);
+        }
+        t3 = clock();
+
+        // Same pattern again, compared tick by tick
+        daemon_ApplyMode();
+        for (i = 0; i < ticks; i++)
+        {
+            ULONG us = daemon_GetAdaptiveInterval(activity[i]);
+            ULONG diff = (us > reference[i]) ? us - reference[i] : reference[i] - us;
+
+            if (diff)
+            {
+                differ++;
+                sumDiff += diff;
+                if (diff > maxDiff) maxDiff = diff;
+            }
+            if (s_adaptiveState != states[i]) stateDiffer++;
+        }
+
+        s_simSink = sumUs;               // Keep the timed loop
+        printf("%-10s %6.1fns %6.1fns %3u/%-4u %7.2f%% %8luus %8luus %7.2f%%\n",
+               profile->adaptiveName,
+               (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / ticks,
+               (double)(t3 - t2) * 1e9 / CLOCKS_PER_SEC / ticks,
+               s_ladderDecLast + 1, s_ladderIncLast + 1,
+               100.0 * differ / ticks,
+               differ ? (unsigned long)(sumDiff / differ) : 0UL, (unsigned long)maxDiff,
+               100.0 * stateDiffer / ticks);
+        free(states);
+    }
+
+    printf("\nHost times only: on 68k the ladder also saves the EClock conversion\n"
+           "of every new interval (ECLOCK/WAITECLOCK units).\n");
+
+    free(activity);
+    free(reference);
+    return 0;
+}
+
+//===========================================================================
+// Tick Reference (config tested every tick, before TICK_VARIANTS)
+//===========================================================================
+
+#define SIM_TICKS_SECONDS   360000      // Virtual seconds per run (TICKS)
+
+/**
+ * Previous daemon_TimerTick(): one body, config bits read every tick.
+ */
+static void sim_GenericTick(void)
+{
+    daemon_TickBody(s_configByte & CONFIG_FEATURES_MASK, TICK_ENGINE(s_configByte));
+}
+
+/**
+ * TICKS mode: every tick handler variant against the generic tick on the
+ * demo workload (BALANCED profile). Both runs must produce the same
+ * wakeups and events; reports host time per tick, simulator included.
+ */
+static int sim_Ticks(int argc, char **argv)
+{
+    ULONG seconds = (argc > 2) ? sim_ParseArg(argv[2]) : SIM_TICKS_SECONDS;
+    UBYTE index;
+    int result = 0;
+
+    if (seconds == 0) seconds = SIM_TICKS_SECONDS;
+
+    printf("XMSim TICKS: demo workload, %lus per run\n\n", (unsigned long)seconds);
+    printf("%-18s %10s %9s %9s %10s %10s %7s\n", "variant", "engine", "wakeups", "events",
+           "generic", "variant", "saved");
+
+    for (index = 0; index < TICK_VARIANT_COUNT; index++)
+    {
+        static const char *names[TICK_VARIANT_COUNT] = {
+#define SIM_TICK_NAME(name, features, engine) #name,
+            TICK_VARIANTS(SIM_TICK_NAME)
+        };
+        UBYTE config = (index & CONFIG_FEATURES_MASK) | (1 << CONFIG_INTERVAL_SHIFT) |
+                       ((index & 4) ? CONFIG_FIXED_MODE : 0) | ((index & 8) ? CONFIG_PREDICTIVE : 0);
+        ULONG wakeups, events;
+        double genericNs, variantNs;
+        clock_t t0, t1;
+
+        // Reference: generic tick
+        sim_Reset();
+        sim_Init(config, DEFAULT_OPTIONS);
+        s_tickHandler = sim_GenericTick;
+        t0 = clock();
+        sim_Run(&s_simDemoWorkload, (SimTime)seconds * 1000000);
+        t1 = clock();
+        wakeups = s_simReport.wakeups;
+        events = s_simReport.events;
+        genericNs = (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / (wakeups ? wakeups : 1);
+
+        // Variant selected by daemon_TickSelect()
+        sim_Reset();
+        sim_Init(config, DEFAULT_OPTIONS);
+        t0 = clock();
+        sim_Run(&s_simDemoWorkload, (SimTime)seconds * 1000000);
+        t1 = clock();
+        variantNs = (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / (s_simReport.wakeups ? s_simReport.wakeups : 1);
+
+        printf("%-18s %10s %9lu %9lu %8.1fns %8.1fns %6.1f%%%s\n", names[index],
+               sim_EngineName(config),
+               (unsigned long)wakeups, (unsigned long)events, genericNs, variantNs,
+               genericNs > 0 ? 100.0 * (genericNs - variantNs) / genericNs : 0.0,
+               (s_simReport.wakeups != wakeups || s_simReport.events != events) ? "  MISMATCH" : "");
+
+        if (s_simReport.wakeups != wakeups || s_simReport.events != events)
+        {
+            result = 1;
+        }
+    }
+
+    printf("\nHost times include the simulated HAL. On 68k, measure per-tick EClock\n"
+           "cost with the daemon itself; the variants only remove config tests.\n");
+
+    return result;
+}
+
+/**
+ * Sort helper for latency percentiles.
+ */
+static int sim_CompareUs(const void *a, const void *b)
+{
+    ULONG x = *(const ULONG *)a, y = *(const ULONG *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Latency percentile of the last run (sorts the samples).
+ * @param percent 1..100
+ * @return Microseconds, 0 without samples
+ */
+static ULONG sim_Percentile(ULONG percent)
+{
+    ULONG n = s_simReport.latencyCount;
+
+    if (!n) return 0;
+
+    qsort(s_simReport.latencyUs, n, sizeof(ULONG), sim_CompareUs);
+    return s_simReport.latencyUs[(n * percent + 99) / 100 - 1];
+}
+
+/**
+ * Print the BENCH header of a workload.
+ */
+static void sim_BenchHeader(ULONG w)
+{
+    printf("\n%-8s %-10s %-10s %8s %9s %9s %6s %6s %6s %6s %6s\n", s_simBenchWorkloads[w].name,
+           "profile", "engine", "wakeup/s", "mean us", "p99 us", "missed", "IDLE", "ACTIVE", "BURST", "TO_IDL");
+}
+
+/**
+ * Run one profile on one workload and print its BENCH line.
+ */
+static void sim_BenchRow(UBYTE config, ULONG options, ULONG seconds, ULONG w)
+{
+    double duration = (double)seconds;
+    const SimReport *r = &s_simReport;
+    ULONG mean, p99;
+    UBYTE st;
+
+    sim_Reset();
+    sim_Init(config, options);
+    sim_Run(&s_simBenchWorkloads[w].workload, (SimTime)seconds * 1000000);
+
+    mean = r->latencyCount ? (ULONG)((r->wheel.sumUs + r->buttons.sumUs) / r->latencyCount) : 0;
+    p99 = sim_Percentile(99);
+
+    printf("         %-10s %-10s %8.1f %9lu %9lu %6lu",
+           (config & CONFIG_FIXED_MODE) ? s_activeMode->normalName : s_activeMode->adaptiveName,
+           sim_EngineName(config),
+           r->wakeups / duration, (unsigned long)mean, (unsigned long)p99,
+           (unsigned long)r->missedButtons);
+
+    if (config & CONFIG_FIXED_MODE)
+    {
+        printf("\n");
+        return;
+    }
+    for (st = 0; st < 4; st++)
+    {
+        printf(" %5.1f%%", 100.0 * r->stateUs[st] / (double)s_simNow);
+    }
+    printf("\n");
+}
+
+/**
+ * BENCH mode: every profile (adaptive, predictive and fixed) on every workload.
+ * Reports wakeups/s, mean/p99 first-event latency (change to injection,
+ * both classes) and the share of time spent in each POLL_STATE_*.
+ */
+static int sim_Bench(int argc, char **argv)
+{
+    ULONG options = (argc > 2) ? sim_ParseArg(argv[2]) : DEFAULT_OPTIONS;
+    ULONG seconds = (argc > 3) ? sim_ParseArg(argv[3]) : SIM_DEFAULT_SECONDS;
+    ULONG w;
+    UBYTE mode;
+
+    if (seconds == 0) seconds = SIM_DEFAULT_SECONDS;
+
+    printf("XMSim BENCH: options 0x%08lx, %lus per run\n", (unsigned long)options, (unsigned long)seconds);
+
+    for (w = 0; w < SIM_BENCH_WORKLOADS; w++)
+    {
+        sim_BenchHeader(w);
+
+        for (mode = 0; mode < 12; mode++)
+        {
+            static const UBYTE engines[3] = { 0, CONFIG_PREDICTIVE, CONFIG_FIXED_MODE };
+
+            sim_BenchRow(CONFIG_FEATURES_MASK | ((mode & 3) << CONFIG_INTERVAL_SHIFT) | engines[mode >> 2],
+                         options, seconds, w);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * PROFILE mode: upload a user profile like XMSG_CMD_SET_PROFILE (slot 0,
+ * same validation) and bench it with the three engines on every workload.
+ * Arguments: idle active burst dec inc grace idle-th curve [0xOPTIONS] [SECONDS]
+ */
+static int sim_Profile(int argc, char **argv)
+{
+    struct XMouseProfile profile;
+    ULONG options = (argc > 10) ? sim_ParseArg(argv[10]) : DEFAULT_OPTIONS;
+    ULONG seconds = (argc > 11) ? sim_ParseArg(argv[11]) : SIM_DEFAULT_SECONDS;
+    ULONG w;
+
+    if (argc < 10)
+    {
+        printf("Usage: xmsim PROFILE idle active burst dec inc grace idle-th curve [0xOPTIONS] [SECONDS]\n");
+        return 1;
+    }
+    if (seconds == 0) seconds = SIM_DEFAULT_SECONDS;
+
+    memset(&profile, 0, sizeof(profile));
+    strcpy(profile.name, "USER");
+    profile.idleUs = sim_ParseArg(argv[2]);
+    profile.activeUs = sim_ParseArg(argv[3]);
+    profile.burstUs = sim_ParseArg(argv[4]);
+    profile.stepDecUs = sim_ParseArg(argv[5]);
+    profile.stepIncUs = sim_ParseArg(argv[6]);
+    profile.activeThreshold = sim_ParseArg(argv[7]);
+    profile.idleThreshold = sim_ParseArg(argv[8]);
+    profile.accelCurve = (UBYTE)sim_ParseArg(argv[9]);
+
+    if (!daemon_ProfileSet(&profile))
+    {
+        printf("XMSim PROFILE: rejected (burst < active <= idle < 1s, steps within range,\n"
+               "ladders up to %d entries, curve 0-%d)\n", ADAPTIVE_LADDER_MAX, ACCEL_CURVE_COUNT - 1);
+        return 1;
+    }
+
+    printf("XMSim PROFILE: options 0x%08lx, %lus per run\n", (unsigned long)options, (unsigned long)seconds);
+
+    for (w = 0; w < SIM_BENCH_WORKLOADS; w++)
+    {
+        sim_BenchHeader(w);
+        sim_BenchRow(CONFIG_FEATURES_MASK | CONFIG_USER_PROFILE, options, seconds, w);
+        sim_BenchRow(CONFIG_FEATURES_MASK | CONFIG_USER_PROFILE | CONFIG_PREDICTIVE, options, seconds, w);
+        sim_BenchRow(CONFIG_FEATURES_MASK | CONFIG_USER_PROFILE | CONFIG_FIXED_MODE, options, seconds, w);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    UBYTE config = DEFAULT_CONFIG_BYTE;
+    ULONG options = DEFAULT_OPTIONS;
+    ULONG seconds = SIM_DEFAULT_SECONDS;
+
+    if (argc > 1 && sim_Keyword(argv[1], "REPLAY"))
+    {
+        return sim_Replay(argc, argv);
+    }
+    if (argc > 1 && sim_Keyword(argv[1], "BENCH"))
+    {
+        return sim_Bench(argc, argv);
+    }
+    if (argc > 1 && sim_Keyword(argv[1], "LADDER"))
+    {
+        return sim_Ladder(argc, argv);
+    }
+    if (argc > 1 && sim_Keyword(argv[1], "TICKS"))
+    {
+        return sim_Ticks(argc, argv);
+    }
+    if (argc > 1 && sim_Keyword(argv[1], "PROFILE"))
+    {
+        return sim_Profile(argc, argv);
+    }
+
+    if (argc > 1) config = (UBYTE)sim_ParseArg(argv[1]);
+    if (argc > 2) options = sim_ParseArg(argv[2]);
+    if (argc > 3) seconds = sim_ParseArg(argv[3]);
+    if (seconds == 0) seconds = SIM_DEFAULT_SECONDS;
+
+    sim_Init(config, options);
+    sim_Run(&s_simDemoWorkload, (SimTime)seconds * 1000000);
+    sim_PrintReport("demo");
+
+    return 0;
+}
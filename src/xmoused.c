@@ -9,6 +9,7 @@
  * Licensed under MIT License
  */
 
+#ifndef XMOUSED_HOST
 #include <proto/exec.h>
 #include <proto/dos.h>
 #include <proto/input.h>
@@ -18,7 +19,14 @@
 #include <devices/input.h>
 #include <devices/timer.h>
 #include <dos/dosextens.h>
+#include <exec/interrupts.h>
+#include <hardware/intbits.h>
 #include <newmouse.h>
+#include <stdarg.h>
+#else
+// Host simulator build: Amiga types and HAL provided by the simulator
+#include "xmoused_host.h"
+#endif
 
 //===========================================================================
 // Application Constants                                                     
@@ -48,6 +56,10 @@
 #define MODE_NAME_REACTIVE      "REACTIVE"
 #define MODE_NAME_ECO           "ECO"
 
+// Adaptive engine names
+#define ENGINE_NAME_LADDER      "adaptive"
+#define ENGINE_NAME_PREDICTIVE  "predictive"
+
 #ifdef RELEASE
     #define PROGRAM_DESC_V          PROGRAM_DESC_SHORT
 #elif XBTTS
@@ -70,12 +82,56 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 #define MSG_DAEMON_STOPPED          "daemon stopped"
 #define MSG_DAEMON_START_FAILED     "failed to start daemon"
 #define MSG_CONFIG_UPDATED          "config updated to 0x%02lx"
+#define MSG_OPTIONS_UPDATED         "options updated to 0x%08lx"
+#define MSG_DAEMON_OPTIONS          "options: 0x%08lx"
 #define MSG_UNKNOWN_ARGUMENT        "unknown argument: %s"
 
 #define MSG_ERR_GET_STATUS_FAILED   "ERROR: Failed to get daemon status"
 #define MSG_ERR_UPDATE_CONFIG       "ERROR: Failed to update daemon config"
+#define MSG_ERR_UPDATE_OPTIONS      "ERROR: Failed to update daemon options"
 #define MSG_ERR_STOP_DAEMON         "ERROR: Failed to stop daemon"
 #define MSG_ERR_DAEMON_TIMEOUT      "ERROR: Daemon not responding (timeout)"
+#define MSG_ERR_GET_TIMING_FAILED   "ERROR: Failed to get timer measurements"
+#define MSG_ERR_GET_STATS_FAILED    "ERROR: Failed to get daemon statistics"
+#define MSG_ERR_GET_CYCLES_FAILED   "ERROR: Failed to get cycle profile (daemon built without MODE=cycles?)"
+#define MSG_ERR_LATENCY_FAILED      "ERROR: Injection latency benchmark failed"
+#define MSG_ERR_CIACOST_FAILED      "ERROR: CIA cost benchmark failed (no free CIA timer?)"
+#define MSG_ERR_SUBSCRIBE_FAILED    "ERROR: Event subscription failed"
+
+#define MSG_TIMING_LINE             "%-10s requested %6ldus, achieved %6ldus"
+#define MSG_TIMING_NONE             "%-10s no samples"
+
+#define MSG_STATS_COUNTERS          "ticks %lu, wakeups %lu, submits %lu"
+#define MSG_STATS_EVENTS            "events: wheel %lu, buttons %lu (max wheel delta %lu)"
+#define MSG_STATS_INTERVAL          "interval: %ldus"
+#define MSG_STATS_STATE             "%-8s %8lu.%03lus"
+#define MSG_STATS_BUCKET            "tick < %6ldus: %lu"
+
+#define MSG_CYCLES_HEADER           "EClock %lu Hz, times in EClock ticks\n" \
+                                    "phase          count    min      mean    max"
+#define MSG_CYCLES_LINE             "%-10s %9lu %6lu %6lu.%02lu %6lu"
+#define MSG_CYCLES_BUCKET           "  < %5lu: %lu"
+#define MSG_CYCLES_BUCKET_LAST      " >= %5lu: %lu"
+
+#define MSG_LATENCY_HEADER          "%lu rounds, one IECLASS_NULL event per round\n" \
+                                    "path            min      mean       max"
+#define MSG_LATENCY_LINE            "%-12s %6ldus %7ldus %7ldus"
+
+#define MSG_CIACOST_HEADER          "CIA sampler, %lums busy loop per rate (multitasking off)\n" \
+                                    "rate    samples/s  CPU"
+#define MSG_CIACOST_LINE            "%5luHz %9lu  %lu.%lu%%"
+
+#define MSG_WATCH_HEADER            PROGRAM_NAME " events - CTRL-C to stop"
+#define MSG_WATCH_WHEEL             "%10lu wheel %s %ld"
+#define MSG_WATCH_BUTTON            "%10lu button %ld %s"
+#define MSG_WATCH_DROPPED           "%10lu (%lu event(s) dropped)"
+#define MSG_WATCH_CLOSED            "daemon stopped sending events"
+
+#define MSG_TOP_HEADER              PROGRAM_NAME " top - CTRL-C to stop\n" \
+                                    "config options    state    interval  ticks/s wakeup/s events/s  submits maxdelta"
+#define MSG_TOP_LINE                "0x%02lx   0x%08lx %-8s %7ldus %8ld %8ld %8ld %8lu %8lu"
+#define TOP_REFRESH_TICKS           50      // DOS ticks between lines (1 second)
+#define SHARED_READ_RETRIES         10      // Odd-sequence retries before giving up
 
 //===========================================================================
 // Newmouse button codes for extra buttons 4 & 5                             
@@ -90,20 +146,56 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 // SAGA USB Mouse Registers                                                  
 //===========================================================================
 
-#ifdef XBTTS
-    // XBttS shared memory location for emulated buttons 4/5
-    // (XBttS daemon writes here when intercepting Amiga+Button1/2)
-    #define XBTTS_SHARED_ADDR       0x1FFFFFFC
-    #define SAGA_MOUSE_BUTTONS      (*((volatile UWORD*)XBTTS_SHARED_ADDR))
-#else
-    #define SAGA_MOUSE_BUTTONS      (*((volatile UWORD*)0xDFF212))
-#endif
-
+// Whole register in one word read: buttons 4/5 (bits 8-9) + wheel counter (bits 0-7)
+#define SAGA_MOUSE_REGISTER     (*((volatile UWORD*)0xDFF212))
 #define SAGA_WHEELCOUNTER       (*((volatile BYTE*)0xDFF212 + 1))
 
-// Button bit masks in SAGA_MOUSE_BUTTONS (bits 8-9)
+// XBttS shared memory location for emulated buttons 4/5, same bits
+// (XBttS daemon writes here when intercepting Amiga+Button1/2)
+#define XBTTS_SHARED_ADDR       0x1FFFFFFC
+#define XBTTS_MOUSE_BUTTONS     (*((volatile UWORD*)XBTTS_SHARED_ADDR))
+
+// Button bit masks in SAGA_MOUSE_REGISTER (bits 8-9)
 #define SAGA_BUTTON4_MASK       0x0100  // Bit 8
 #define SAGA_BUTTON5_MASK       0x0200  // Bit 9
+#define SAGA_BUTTONS_MASK       (SAGA_BUTTON4_MASK | SAGA_BUTTON5_MASK)
+#define SAGA_WHEEL_MASK         0x00FF  // Bits 0-7 (wheel counter)
+
+// One register snapshot, decoded (daemon_DecodeSample)
+typedef struct
+{
+    BYTE wheel;                 // Vertical wheel counter (absolute, wraps)
+    BYTE hwheel;                // Horizontal wheel counter (no source yet, 0)
+    UWORD buttons;              // SAGA_BUTTON*_MASK bits, room for 16 buttons
+} MouseSample;
+
+
+//===========================================================================
+// Hardware Abstraction Layer
+//===========================================================================
+
+// The polling core (tick, injection, timer, adaptive) only reaches the
+// hardware and the OS through these macros. The host simulator build
+// (XMOUSED_HOST, src-sim) provides its own versions from xmoused_host.h.
+#ifndef XMOUSED_HOST
+    // Register snapshot: one word read, buttons from XBttS memory with OPT_SOURCE_XBTTS
+    #define HAL_ReadRegister()      ((s_options & OPT_SOURCE_XBTTS) ? \
+                                     (UWORD)((XBTTS_MOUSE_BUTTONS & SAGA_BUTTONS_MASK) | (UBYTE)SAGA_WHEELCOUNTER) : \
+                                     SAGA_MOUSE_REGISTER)
+    
+    // Clock: 64-bit EClock, returns EClock frequency
+    #define HAL_ReadClock(ev)       ReadEClock(ev)
+    
+    // Timer: send a prepared TR_ADDREQUEST
+    #define HAL_TimerSend(req)      SendIO((struct IORequest *)(req))
+    
+    // Inject: write a prepared IND_WRITEEVENT request
+    #define HAL_PeekQualifier()     PeekQualifier()
+    #define HAL_InjectSync(req)     DoIO((struct IORequest *)(req))
+    #define HAL_InjectAsync(req)    SendIO((struct IORequest *)(req))
+    #define HAL_InjectReaped(port)  ((struct IORequest *)GetMsg(port))
+    #define HAL_InjectWait(req)     WaitIO((struct IORequest *)(req))
+#endif
 
 
 //===========================================================================
@@ -114,6 +206,17 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 #define XMSG_CMD_QUIT           0   // Stop daemon
 #define XMSG_CMD_SET_CONFIG     1   // Set config byte
 #define XMSG_CMD_GET_STATUS     2   // Get current status
+#define XMSG_CMD_SET_OPTIONS    3   // Set extended options word
+#define XMSG_CMD_GET_OPTIONS    4   // Get extended options word
+#define XMSG_CMD_GET_TIMING     5   // Get timer measurements (value: in=unit, out=requested mean us)
+#define XMSG_CMD_SET_PROFILE    6   // Upload a user profile (value: struct XMouseProfile *)
+#define XMSG_CMD_GET_STATS      7   // Copy runtime statistics (value: struct XMouseStats *, result: version)
+#define XMSG_CMD_GET_CYCLES     8   // Copy cycle profile (value: struct XMouseCycles *, result: version)
+#define XMSG_CMD_BENCH_LATENCY  9   // Injection latency benchmark (value: struct XMouseLatency *, result: version)
+#define XMSG_CMD_BENCH_CIA      10  // CIA sampler CPU cost per rate (value: struct XMouseCiaCost *, result: version)
+#define XMSG_CMD_SUBSCRIBE      11  // Send events to a client port (value: struct XMouseSubscribe *, result: version)
+#define XMSG_CMD_UNSUBSCRIBE    12  // Stop sending events (value: client struct MsgPort *)
+#define XMSG_CMD_REQUEST        13  // Tag request (struct XMouseRequest), see Control Requests
 
 // Daemon communication timeout
 #define DAEMON_REPLY_TIMEOUT    2   // Seconds to wait for daemon reply
@@ -128,11 +231,19 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 #define START_MODE_STOP 2
 #define START_MODE_CONFIG 3
 #define START_MODE_STATUS 4
+#define START_MODE_TIMING 5
+#define START_MODE_STATS 6
+#define START_MODE_TOP 7
+#define START_MODE_CYCLES 8
+#define START_MODE_LATENCY 9
+#define START_MODE_CIACOST 10
+#define START_MODE_WATCH 11
 
 // Configuration byte bits
 #define CONFIG_WHEEL_ENABLED    0x01    // Bit 0: Wheel enabled (RawKey + NewMouse) (0b00000001)
 #define CONFIG_BUTTONS_ENABLED  0x02    // Bit 1: Extra buttons 4 & 5 enabled (0b00000010)
-// Bits 2-3: Reserved
+#define CONFIG_PREDICTIVE       0x04    // Bit 2: Adaptive engine (0=ladders, 1=predictive EWMA), ignored in fixed mode (0b00000100)
+#define CONFIG_USER_PROFILE     0x08    // Bit 3: Profile source (0=built-in, 1=user slot selected by bits 4-5) (0b00001000)
 #define CONFIG_INTERVAL_SHIFT   4       // Bits 4-5: Mode selection (00=COMFORT, 01=BALANCED, 10=REACTIVE)
 #define CONFIG_INTERVAL_MASK    0x30    // Mode mask (0b00110000)
 #define CONFIG_FIXED_MODE       0x40    // Bit 6: Polling mode (0=adaptive, 1=normal/constant) (0b01000000)
@@ -144,6 +255,30 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 
 #define DEFAULT_CONFIG_BYTE     0x13    // Default: Wheel ON, Buttons ON, BALANCED mode (01), Debug OFF (0b00010011)
 
+// Extended options word (optional second argument 0xOPTIONS)
+#define OPT_ASYNC_INJECT        0x00000001  // Bit 0: Non-blocking injection (SendIO request ring)
+#define OPT_WHEEL_COALESCE      0x00000002  // Bit 1: One wheel event pair per tick, count in ie_Y (0=per-detent pairs)
+#define OPT_WHEEL_ACCEL         0x00000004  // Bit 2: Velocity-based wheel acceleration (profile curve)
+#define OPT_VBL_SAMPLING        0x00000008  // Bit 3: Event-driven sampling from a VBL interrupt (no timer)
+#define OPT_TIMER_UNIT_SHIFT    4           // Bits 4-5: Timer unit (00=VBLANK, 01=MICROHZ, 10=ECLOCK, 11=WAITECLOCK)
+#define OPT_TIMER_UNIT_MASK     0x00000030
+#define OPT_TRACE_CAPTURE       0x00000040  // Bit 6: Record samples/injections in RAM, saved to TRACE_FILE_NAME on stop
+#define OPT_PREWARM             0x00000080  // Bit 7: Pointer/button 1-3 input wakes adaptive polling from IDLE
+#define OPT_HANDLER_INJECT      0x00000100  // Bit 8: Chains spliced into the input stream by our handler (no IND_WRITEEVENT)
+#define OPT_CIA_SAMPLING        0x00000200  // Bit 9: Gaming mode, sample from a CIA timer interrupt (overrides bit 3)
+#define OPT_CIA_RATE_SHIFT      10          // Bits 10-11: CIA sample rate (00=1kHz, 01=2kHz, 10=4kHz, 11=8kHz)
+#define OPT_CIA_RATE_MASK       0x00000C00
+#define OPT_SOURCE_XBTTS        0x00001000  // Bit 12: Buttons 4/5 from XBttS shared memory (wheel still from $DFF213)
+#define OPT_WHEEL_SMOOTH        0x00002000  // Bit 13: Spread the detents of one tick over the next poll interval
+#define OPT_SMOOTH_FRAMES_SHIFT 14          // Bits 14-15: Smoothing window (00=next poll interval, 01-11=1-3 frames)
+#define OPT_SMOOTH_FRAMES_MASK  0x0000C000
+
+#ifdef XBTTS
+    #define DEFAULT_OPTIONS     OPT_SOURCE_XBTTS  // XBTTS build: emulated buttons by default
+#else
+    #define DEFAULT_OPTIONS     0x00000000  // Default: all extended options OFF
+#endif
+
 
 //===========================================================================
 // Variables
@@ -152,10 +287,15 @@ PROGRAM_NAME " " PROGRAM_VERSION " (" PROGRAM_DATE ") " PROGRAM_DESC_V \
 struct ExecBase *SysBase;              // Exec base (absolute 4)
 struct DosLibrary *DOSBase;            // DOS library base
 struct Device * InputBase;
+struct Device * TimerBase;             // Timer device base (ReadEClock)
+#ifndef XMOUSED_HOST
 static struct MsgPort *s_PublicPort;   // Singleton port
+#endif
 static struct MsgPort *s_InputPort;    // Input device port
 static struct IOStdReq *s_InputReq;    // Input IO request
+#ifndef XMOUSED_HOST
 static struct MsgPort *s_TimerPort;    // Timer port
+#endif
 static struct timerequest *s_TimerReq; // Timer IO request
 
 static BYTE s_lastWHCounter;           // Last wheel position
@@ -165,18 +305,164 @@ static UWORD s_lastBTState;            // Last button state
 
 static ULONG s_pollInterval;           // Timer interval (microseconds)
 static UBYTE s_configByte;             // Configuration byte
-static struct InputEvent s_eventBuf;   // Reusable event buffer
+static ULONG s_options = DEFAULT_OPTIONS; // Extended options word
+#ifndef XMOUSED_HOST
+static BOOL s_optionsSet;              // Options given on command line
+static ULONG s_replyValue;             // Value field of the last daemon reply
+#endif
+
+//===========================================================================
+// Timer Units
+//===========================================================================
+
+// UNIT_VBLANK only resolves whole frames (16-20ms), MICROHZ and ECLOCK
+// honour short intervals. ECLOCK requests are given in EClock ticks.
+// WAITECLOCK waits for absolute EClock deadlines: ticks stay on a fixed
+// grid, processing time and injection delays do not add to the period.
+#define TIMER_UNIT_VBLANK       0
+#define TIMER_UNIT_MICROHZ      1
+#define TIMER_UNIT_ECLOCK       2
+#define TIMER_UNIT_WAITECLOCK   3
+#define TIMER_UNIT_COUNT        4
+
+#define TIMER_STATS_MAX         1024    // Samples before halving sums (sliding mean)
+#define TIMER_REPORT_TICKS      256     // Debug report period (ticks)
+#define TIMER_MAX_SKIP          8       // Missed deadlines skipped before resync
+
+// Measured intervals per unit: requested vs. achieved
+typedef struct
+{
+    ULONG count;               // Measured ticks
+    ULONG requestedUs;         // Sum of requested intervals (microseconds)
+    ULONG elapsedClock;        // Sum of achieved intervals (EClock ticks)
+} TimerStats;
+
+static const ULONG s_timerDeviceUnits[TIMER_UNIT_COUNT] = { UNIT_VBLANK, UNIT_MICROHZ, UNIT_ECLOCK, UNIT_WAITECLOCK };
+static const char *s_timerUnitNames[TIMER_UNIT_COUNT] = { "VBLANK", "MICROHZ", "ECLOCK", "WAITECLOCK" };
+
+static UBYTE s_timerUnit;              // Opened unit (TIMER_UNIT_*)
+static ULONG s_eclockFreq;             // EClock frequency (Hz)
+static ULONG s_eclockPerUsQ12;         // EClock ticks per microsecond (20.12 fixed point)
+static ULONG s_timerStartClock;        // EClock at start of the pending period
+static ULONG s_timerFireClock;         // EClock when the last request completed
+static ULONG s_timerRequested;         // Interval of the pending request (microseconds)
+static ULONG s_timerTicksUs;           // Interval converted in s_timerTicks (microseconds)
+static ULONG s_timerTicks;             // Interval in EClock ticks
+static struct EClockVal s_timerDeadline; // Absolute deadline of pending request (WAITECLOCK)
+static ULONG s_timerSkipped;           // Deadlines skipped while running late
+static TimerStats s_timerStats[TIMER_UNIT_COUNT];
+
+//===========================================================================
+// Event Injection Pipeline
+//===========================================================================
+
+// All events of a tick are linked through ie_NextEvent and written to
+// input.device with a single IND_WRITEEVENT request.
+// 64 events = 32 wheel detents (RAWKEY + NEWMOUSE pairs) per submission,
+// larger deltas submit the chain and continue in the next slot.
+#define INJECT_POOL_SIZE        64
+#define INJECT_RING_SIZE        4       // Requests in flight (async mode)
+#define INJECT_PENDING_MAX      8       // Button codes held while ring is full
+
+// Request slot: one IOStdReq and its event chain
+typedef struct
+{
+    struct IOStdReq *req;                         // Request (slot 0 = s_InputReq)
+    struct InputEvent events[INJECT_POOL_SIZE];   // Preallocated event chain
+    UWORD count;                                  // Events queued in chain
+    BOOL busy;                                    // Request in flight (async mode)
+} InjectSlot;
+
+static InjectSlot s_injectRing[INJECT_RING_SIZE];
+static InjectSlot *s_injectSlot;       // Slot being filled (NULL = ring full)
+static UBYTE s_injectNext;             // Next ring slot to try (round robin)
+static UWORD s_eventQualifier;         // Qualifier captured once per tick
+static UWORD s_tickSubmits;            // IND_WRITEEVENT requests sent this tick
+static int s_pendingWheel;             // Wheel detents merged while ring is full
+static UWORD s_pendingButtons[INJECT_PENDING_MAX]; // Button codes waiting for a slot
+static UBYTE s_pendingButtonCount;
+
+//===========================================================================
+// Handler Injection
+//===========================================================================
+
+// Options bit 8: a filled chain is not written with IND_WRITEEVENT but
+// queued for an input handler at the head of the input chain, which links
+// it in front of the events it is processing. The daemon never waits for
+// input.device. To bound latency when no other input arrives, one
+// IECLASS_NULL "kick" event is kept in flight with SendIO while chains
+// are queued. A slot is released when a kick sent after its chain was
+// queued is replied: by then input.device has spliced the chain and run
+// it through every handler, whatever the task priorities.
+#define INJECT_HANDLER_PRI      100     // Ahead of every handler, like IND_WRITEEVENT
+#define HANDLER_QUEUE_SIZE      8       // Queued chains (power of 2, > INJECT_RING_SIZE)
+
+typedef struct
+{
+    struct InputEvent * volatile first[HANDLER_QUEUE_SIZE];  // Chain heads
+    struct InputEvent * volatile last[HANDLER_QUEUE_SIZE];   // Chain tails, linked to the stream
+    volatile ULONG spliceClock[HANDLER_QUEUE_SIZE];          // EClock when spliced (benchmark)
+    volatile UBYTE head;       // Written by daemon only
+    volatile UBYTE tail;       // Written by handler only
+} HandlerQueue;
+
+#ifndef XMOUSED_HOST
+static HandlerQueue s_handlerQueue;
+static InjectSlot *s_handlerSlots[HANDLER_QUEUE_SIZE];  // Slot owning each queued chain (daemon only)
+static UBYTE s_handlerReleased;        // Next queue entry to release (daemon only)
+static UBYTE s_kickHead;               // Queue head when the kick was sent (daemon only)
+static struct Interrupt s_injectInterrupt;
+static struct IOStdReq *s_handlerReq = NULL;   // IND_ADDHANDLER/IND_REMHANDLER request (NULL = handler off)
+static struct IOStdReq *s_kickReq = NULL;      // IECLASS_NULL kick request
+static struct InputEvent s_kickEvent;
+static BOOL s_kickBusy;                        // Kick in flight
+#endif
+
+// Latency benchmark (XMSG_CMD_BENCH_LATENCY): the same IECLASS_NULL event
+// sent through each path, times in EClock ticks from submission
+#define LATENCY_VERSION         1
+#define LATENCY_ROUNDS          100
+#define LATENCY_PATH_DOIO       0       // IND_WRITEEVENT + DoIO, until the reply
+#define LATENCY_PATH_SPLICE     1       // Handler queue + kick, until spliced into the stream
+#define LATENCY_PATH_KICK       2       // Handler queue + kick, until the kick reply
+#define LATENCY_PATH_COUNT      3
+
+struct XMouseLatency
+{
+    UWORD version;                  // LATENCY_VERSION (set by daemon)
+    UWORD size;                     // In: buffer size, out: bytes written
+    ULONG eclockFreq;               // EClock frequency (time unit)
+    ULONG rounds;                   // Rounds per path
+    ULONG min[LATENCY_PATH_COUNT];  // EClock ticks
+    ULONG mean[LATENCY_PATH_COUNT];
+    ULONG max[LATENCY_PATH_COUNT];
+};
+
+#ifndef XMOUSED_HOST
+static const char *s_latencyPathNames[LATENCY_PATH_COUNT] = { "doio", "handler", "handler+kick" };
+#endif
 
 //===========================================================================
 // Adaptive Polling System
 //===========================================================================
 
+// Wheel acceleration curves (index in s_accelCurves)
+#define ACCEL_CURVE_LINEAR   0  // 1:1, no acceleration
+#define ACCEL_CURVE_GENTLE   1  // Up to x2
+#define ACCEL_CURVE_MEDIUM   2  // Up to x3
+#define ACCEL_CURVE_STRONG   3  // Up to x4
+#define ACCEL_CURVE_COUNT    4
+
 // Polling states
 #define POLL_STATE_IDLE      0  // At rest, interval = idleUs
 #define POLL_STATE_ACTIVE    1  // Activity detected, interval descending toward burstUs
 #define POLL_STATE_BURST     2  // Peak usage, interval = burstUs (floor)
 #define POLL_STATE_TO_IDLE   3  // Returning to idle, interval ascending toward idleUs
 
+#ifndef XMOUSED_HOST
+static const char *s_pollStateNames[4] = { "IDLE", "ACTIVE", "BURST", "TO_IDLE" };
+#endif
+
 // Adaptive mode configuration
 typedef struct
 {
@@ -189,28 +475,96 @@ typedef struct
     ULONG stepIncUs;          // Microseconds to increment per tick (TO_IDLE → IDLE)
     ULONG activeThreshold;    // Microseconds of inactivity before transitioning from ACTIVE to TO_IDLE (human grace period)
     ULONG idleThreshold;      // Microseconds of inactivity before transitioning from BURST to TO_IDLE
+    UBYTE accelCurve;         // Wheel acceleration curve (ACCEL_CURVE_*), used with OPT_WHEEL_ACCEL
 } AdaptiveMode;
 
 // Mode table indexed by config bits 4-5
 // 4 base modes x 2 variants (adaptive/normal via bit 6) = 8 total modes:
 //   Adaptive (bit6=0): COMFORT, BALANCED, REACTIVE, ECO
 //   Normal (bit6=1):   MODERATE (20ms), ACTIVE (10ms), INTENSIVE (5ms), PASSIVE (40ms)
+// Columns: adaptive, normal, idleUs, activeUs, burstUs, stepDecUs, stepIncUs,
+//          activeThreshold, idleThreshold, accelCurve
+#define ADAPTIVE_PROFILES(P) \
+    /* COMFORT (00): Relaxed, tolerant */ \
+    P(COMFORT,  MODERATE,  150000, 60000, 20000, 1100, 15000, 500000,  500000, GENTLE) \
+    /* BALANCED (01): Balanced, universal - DEFAULT */ \
+    P(BALANCED, ACTIVE,    100000, 30000, 10000,  600,  1200, 500000, 1500000, MEDIUM) \
+    /* REACTIVE (10): Nervous, snappy */ \
+    P(REACTIVE, INTENSIVE,  50000, 15000,  5000,  500,   250, 500000, 3000000, STRONG) \
+    /* ECO (11): Low-power/quiet, 200->80->40ms | Fixed: 40ms (PASSIVE) */ \
+    P(ECO,      PASSIVE,   200000, 80000, 40000, 2000,  4000, 500000, 1500000, GENTLE)
+
+#define ADAPTIVE_MODE_ROW(a, n, idle, active, burst, dec, inc, athr, ithr, curve) \
+    { MODE_NAME_##a, MODE_NAME_##n, idle, active, burst, dec, inc, athr, ithr, ACCEL_CURVE_##curve },
+
 static const AdaptiveMode s_adaptiveModes[] = 
 {
-    // COMFORT (00): Relaxed, tolerant
-    { MODE_NAME_COMFORT, MODE_NAME_MODERATE, 150000, 60000, 20000, 1100, 15000, 500000, 500000 },
-    
-    // BALANCED (01): Balanced, universal - DEFAULT
-    { MODE_NAME_BALANCED, MODE_NAME_ACTIVE, 100000, 30000, 10000, 600, 1200, 500000, 1500000 },
-    
-    // REACTIVE (10): Nervous, snappy
-    { MODE_NAME_REACTIVE, MODE_NAME_INTENSIVE, 50000, 15000, 5000, 500, 250, 500000, 3000000 },
+    ADAPTIVE_PROFILES(ADAPTIVE_MODE_ROW)
+};
+
+//===========================================================================
+// User Profiles
+//===========================================================================
+
+// Config bit 3 selects a user slot (bits 4-5) instead of a built-in row.
+// Slots start as copies of the built-in rows and are replaced by
+// XMSG_CMD_SET_PROFILE or by PROFILE_FILE_NAME at startup. Uploads are
+// checked at run time with the rules ADAPTIVE_PROFILE_CHECK applies to
+// the built-in rows at build time.
+#define PROFILE_USER_SLOTS      4
+#define PROFILE_NAME_MAX        16      // Including NUL
+#define PROFILE_FILE_NAME       "ENV:XMouseD.profiles"
+#define PROFILE_LINE_MAX        160
 
-    // ECO (11): Low-power/quiet
-    // Dynamic: 200→80→40ms | Fixed: 40ms (PASSIVE)
-    // stepDecUs=2000, stepIncUs=4000, thresholds: 500ms/1.5s
-    { MODE_NAME_ECO, MODE_NAME_PASSIVE, 200000, 80000, 40000, 2000, 4000, 500000, 1500000 }
+static AdaptiveMode s_userModes[PROFILE_USER_SLOTS] =
+{
+    ADAPTIVE_PROFILES(ADAPTIVE_MODE_ROW)
 };
+static char s_userNames[PROFILE_USER_SLOTS][PROFILE_NAME_MAX];
+
+//===========================================================================
+// Adaptive Ladders
+//===========================================================================
+
+// The profile of the active mode is compiled into two ladders of ready-made
+// intervals (microseconds and EClock ticks):
+//   descent: start -> burstUs by stepDecUs (ACTIVE, last entry = BURST)
+//   ascent:  start -> idleUs by stepIncUs  (TO_IDLE, last entry = IDLE)
+// A tick moves one entry: no subtraction, clamp or conversion per tick.
+// A ladder starts at the interval the state machine is in when entering
+// it (activeUs from IDLE), so it is refilled only when a transition
+// starts from another interval than last time.
+#define ADAPTIVE_LADDER_MAX     192     // Entries per ladder (UBYTE index)
+
+// Entries of a ladder from 'from' to 'to' by 'step' (both ends included)
+#define ADAPTIVE_LADDER_LEN(from, to, step) \
+    ((((from) > (to) ? (from) - (to) : (to) - (from)) + (step) - 1) / (step) + 1)
+
+#define STATIC_ASSERT(name, cond) typedef char static_assert_##name[(cond) ? 1 : -1]
+
+// Build-time validation of every profile row
+#define ADAPTIVE_PROFILE_CHECK(a, n, idle, active, burst, dec, inc, athr, ithr, curve) \
+    STATIC_ASSERT(a##_order, (burst) > 0 && (burst) < (active) && (active) <= (idle)); \
+    STATIC_ASSERT(a##_below_1s, (idle) < 1000000); \
+    STATIC_ASSERT(a##_steps, (dec) > 0 && (dec) <= (active) - (burst) && (inc) > 0 && (inc) <= (idle) - (burst)); \
+    STATIC_ASSERT(a##_descent_fits, ADAPTIVE_LADDER_LEN(active, burst, dec) <= ADAPTIVE_LADDER_MAX); \
+    STATIC_ASSERT(a##_ascent_fits, ADAPTIVE_LADDER_LEN(idle, burst, inc) <= ADAPTIVE_LADDER_MAX);
+
+ADAPTIVE_PROFILES(ADAPTIVE_PROFILE_CHECK)
+
+// Ladder entry: one interval, ready for timer.device
+typedef struct
+{
+    ULONG us;                  // Interval (microseconds): VBLANK/MICROHZ tv_micro
+    ULONG ticks;               // Interval (EClock ticks): ECLOCK/WAITECLOCK
+} AdaptiveStep;
+
+static AdaptiveStep s_ladderDec[ADAPTIVE_LADDER_MAX];  // Descent, [0] = interval entering ACTIVE
+static AdaptiveStep s_ladderInc[ADAPTIVE_LADDER_MAX];  // Ascent, [0] = interval entering TO_IDLE
+static UBYTE s_ladderDecLast;                          // BURST entry
+static UBYTE s_ladderIncLast;                          // IDLE entry
+static ULONG s_adaptiveThreshold[4];                   // Inactivity before TO_IDLE, per POLL_STATE_*
+static UBYTE s_adaptiveStep;                           // Entry in the ladder of the current state
 
 // Adaptive state variables
 static const AdaptiveMode *s_activeMode = NULL;
@@ -218,1114 +572,5820 @@ static UBYTE s_adaptiveState = POLL_STATE_IDLE;     // Current polling state
 static ULONG s_adaptiveInterval = 0;                    // Current polling interval (microseconds)
 static ULONG s_adaptiveInactive = 0;                   // Accumulated inactive time (microseconds)
 
-// XMouse control message
-struct XMouseMsg
+//===========================================================================
+// Predictive Polling
+//===========================================================================
+
+// Config bit 2 replaces the ladders with a prediction of the next event:
+// an exponentially weighted mean of the time between active ticks and its
+// mean deviation (integer shifts only). After activity the next tick is
+// set just before the predicted arrival, the window around it is polled
+// finely, a missed prediction backs off with the silence. Every interval
+// is bounded by the profile's burstUs and idleUs.
+#define PREDICT_GAP_SHIFT       2       // Mean gap weight: 1/4
+#define PREDICT_DEV_SHIFT       2       // Mean deviation weight: 1/4
+#define PREDICT_WINDOW_SHIFT    1       // Event expected until gap + 2 x deviation
+#define PREDICT_BACKOFF_SHIFT   1       // Missed: next interval = silence / 2
+
+static ULONG s_predictGap;             // Mean time between active ticks (microseconds)
+static ULONG s_predictDev;             // Mean deviation of the gap (microseconds)
+static ULONG s_predictElapsed;         // Time since the last active tick (microseconds)
+
+//===========================================================================
+// Tick Handlers
+//===========================================================================
+
+// One timer tick handler per feature/mode combination, all expanded from
+// daemon_TickBody() with constant flags: disabled paths are dropped at
+// compile time and no config bit is tested per tick. Rows are in
+// TICK_INDEX() order (bits 0-1 features, bits 2-3 fixed/predictive).
+#define TICK_VARIANTS(V) \
+    V(NoneAdaptive,      0,                      0) \
+    V(WheelAdaptive,     CONFIG_WHEEL_ENABLED,   0) \
+    V(ButtonsAdaptive,   CONFIG_BUTTONS_ENABLED, 0) \
+    V(BothAdaptive,      CONFIG_FEATURES_MASK,   0) \
+    V(NoneFixed,         0,                      CONFIG_FIXED_MODE) \
+    V(WheelFixed,        CONFIG_WHEEL_ENABLED,   CONFIG_FIXED_MODE) \
+    V(ButtonsFixed,      CONFIG_BUTTONS_ENABLED, CONFIG_FIXED_MODE) \
+    V(BothFixed,         CONFIG_FEATURES_MASK,   CONFIG_FIXED_MODE) \
+    V(NonePredictive,    0,                      CONFIG_PREDICTIVE) \
+    V(WheelPredictive,   CONFIG_WHEEL_ENABLED,   CONFIG_PREDICTIVE) \
+    V(ButtonsPredictive, CONFIG_BUTTONS_ENABLED, CONFIG_PREDICTIVE) \
+    V(BothPredictive,    CONFIG_FEATURES_MASK,   CONFIG_PREDICTIVE)
+
+#define TICK_VARIANT_COUNT  12
+
+// Polling engine of a config byte: CONFIG_FIXED_MODE, CONFIG_PREDICTIVE or 0 (ladders)
+#define TICK_ENGINE(config) \
+    (((config) & CONFIG_FIXED_MODE) ? CONFIG_FIXED_MODE : ((config) & CONFIG_PREDICTIVE))
+
+#define TICK_INDEX(config) \
+    (((config) & CONFIG_FEATURES_MASK) | (((config) & CONFIG_FIXED_MODE) ? 4 : \
+                                          ((config) & CONFIG_PREDICTIVE) ? 8 : 0))
+
+typedef void (*TickHandler)(void);
+
+static TickHandler s_tickHandler;      // Handler of the current config (daemon_TickSelect)
+
+//===========================================================================
+// Wheel Acceleration
+//===========================================================================
+
+// Velocity = detents seen during the last 1/ACCEL_WINDOW_DIV second,
+// kept as a running sum over time slices of the window (EClock, computed
+// once at init), so it doesn't depend on how often the daemon polls.
+// The hot path only adds, compares, multiplies and shifts.
+#define ACCEL_SLICES         16     // Window slices (power of 2)
+#define ACCEL_SPEED_STEPS    16     // Velocity buckets per curve
+#define ACCEL_WINDOW_DIV     10     // Window = 100ms, bucket N = N*10 detents/s
+
+// Gain per velocity bucket, 8.8 fixed point (256 = 1:1)
+static const UWORD s_accelCurves[ACCEL_CURVE_COUNT][ACCEL_SPEED_STEPS] =
 {
-    struct Message msg;
-    UBYTE command;      // XMSG_CMD_* 
-    ULONG value;        // Command parameter 
-    ULONG result;       // Result/status 
+    // LINEAR
+    { 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256, 256 },
+    // GENTLE: x1 up to 20 det/s, x2 from 90 det/s
+    { 256, 256, 256, 288, 320, 352, 384, 416, 448, 480, 512, 512, 512, 512, 512, 512 },
+    // MEDIUM: x1 up to 10 det/s, x3 from 90 det/s
+    { 256, 256, 288, 320, 384, 448, 512, 576, 640, 704, 768, 768, 768, 768, 768, 768 },
+    // STRONG: x4 from 80 det/s
+    { 256, 288, 352, 448, 576, 704, 832, 960, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024 }
 };
 
-#ifndef RELEASE
-    static ULONG s_pollCount = 0;
-    static BPTR s_debugCon = 0;
+static UBYTE s_accelSlices[ACCEL_SLICES];  // Detents per slice (saturated at 255)
+static UBYTE s_accelSlice;     // Current slice
+static ULONG s_accelSliceStart;  // EClock (low 32 bits) where the current slice began
+static UWORD s_accelSum;       // Detents in all slices (velocity)
+static BYTE s_accelDir;        // Direction of the counted detents (1=UP, -1=DOWN)
+static UWORD s_accelFrac;      // Fractional detents carried to next tick (1/256)
+static ULONG s_accelWindow;    // Velocity window in EClock ticks
+static ULONG s_accelSliceTicks;  // s_accelWindow / ACCEL_SLICES
+
+//===========================================================================
+// Trace Capture
+//===========================================================================
+
+// Register changes and submitted chains are recorded with their EClock
+// time into a buffer allocated when capture starts. The file is written
+// only when capture stops (option cleared or daemon quit): no I/O while
+// polling. Traces are replayed by xmsim (src-sim) through the same core.
+// With timer polling, a record-only VBL server stamps register changes
+// next to the unchanged poll path, so sample times don't depend on the
+// poll interval being measured.
+// File: TraceHeader followed by TraceRecord[count], big-endian.
+#define TRACE_FILE_NAME      "T:XMouseD.trace"
+#define TRACE_MAGIC          0x584D5452  // 'XMTR'
+#define TRACE_VERSION        2           // v2: sampling source in header
+#define TRACE_RECORDS_MAX    8192        // 64KB, changes only (not every tick)
+
+#define TRACE_SAMPLE         0           // Register changed: value = $DFF212 (watched bits)
+#define TRACE_INJECT         1           // Chain submitted: value = event count
+
+#define TRACE_SOURCE_TIMER   0           // Sampled at poll time (onsets rounded to the interval)
+#define TRACE_SOURCE_VBL     1           // Sampled every frame
+#define TRACE_SOURCE_CIA     2           // Sampled at the CIA rate
+
+#define TRACE_RING_SIZE      16          // Stamped changes between daemon wakeups (power of 2)
+
+typedef struct
+{
+    ULONG clock;               // EClock (low 32 bits, wraps)
+    UWORD value;               // Sample or event count
+    UWORD type;                // TRACE_*
+} TraceRecord;
+
+typedef struct
+{
+    ULONG magic;               // TRACE_MAGIC
+    UWORD version;             // TRACE_VERSION
+    UBYTE config;              // Config byte at start of capture
+    UBYTE timerUnit;           // TIMER_UNIT_* at start of capture
+    ULONG options;             // Options word at start of capture
+    ULONG eclockFreq;          // EClock frequency (Hz)
+    ULONG ticks;               // Daemon wakeups during capture
+    ULONG count;               // Records following the header
+    ULONG dropped;             // Records lost (buffer full)
+    UWORD source;              // TRACE_SOURCE_* (coarsest used during capture)
+} TraceHeader;
+
+static TraceRecord *s_trace = NULL;    // Capture buffer (NULL = capture off)
+static TraceHeader s_traceHeader;      // Header, counters updated while capturing
+static UWORD s_traceLast;              // Last recorded sample
+
+// Record-only VBL sampler (capture with timer polling): no signal, drained by the daemon
+typedef struct
+{
+    volatile UWORD samples[TRACE_RING_SIZE];  // Raw register samples (masked)
+    volatile ULONG clocks[TRACE_RING_SIZE];   // EClock (low 32 bits) of each sample
+    volatile UBYTE head;       // Written by interrupt only
+    volatile UBYTE tail;       // Written by daemon only
+    volatile UWORD mask;       // Register bits watched (wheel/buttons enabled)
+    volatile ULONG lost;       // Changes lost while the ring was full
+    UWORD last;                // Last sample seen by interrupt
+} TraceSampler;
+
+static TraceSampler s_traceSampler;
+#ifndef XMOUSED_HOST
+static struct Interrupt s_traceInterrupt;
 #endif
+static BOOL s_traceSamplerOn = FALSE;  // Server installed
 
-// Version string - uses APP_* macros
-const char version[] = VERSION_STRING;
+//===========================================================================
+// VBL Sampling (event-driven mode)
+//===========================================================================
+
+// A vertical-blank interrupt server reads the SAGA register once per frame
+// and pushes changed samples into a single-producer/single-consumer ring.
+// The daemon is signalled only on change: no idle wakeups, and button taps
+// shorter than the poll interval are kept as separate samples.
+#define VBL_MAILBOX_SIZE     16     // Samples held between daemon wakeups (power of 2)
+#define VBL_SERVER_PRI       -60    // Run after system VBL servers
+
+typedef struct
+{
+    volatile UWORD samples[VBL_MAILBOX_SIZE];  // Raw register samples (masked)
+    volatile UBYTE head;       // Written by interrupt only
+    volatile UBYTE tail;       // Written by daemon only
+    volatile UWORD mask;       // Register bits watched (wheel/buttons enabled)
+    UWORD last;                // Last sample seen by interrupt
+    struct Task *task;         // Daemon task to signal
+    ULONG signal;              // Signal mask
+} VblMailbox;
 
+static VblMailbox s_vblMailbox;
+#ifndef XMOUSED_HOST
+static struct Interrupt s_vblInterrupt;
+static ULONG s_vblSignal = 0;  // Daemon signal mask (0 = VBL sampling off)
+static BYTE s_vblSigBit = -1;  // Allocated signal bit
+#endif
 
 //===========================================================================
-// Function Prototypes
+// Pre-warm Handler
 //===========================================================================
 
-static ULONG sendDaemonMessage(struct MsgPort *port, UBYTE cmd, ULONG value);
-static inline int parseHexDigit(UBYTE c);
-static inline BYTE parseArguments(void);
-static inline const char* getModeName(UBYTE configByte);
+// Optional input handler ahead of Intuition. While the daemon idles it
+// arms a one-shot gate; the first RAWMOUSE event (motion, buttons 1-3)
+// disarms it and signals the daemon, which jumps to ACTIVE before the
+// wheel is touched. Disarmed, the handler is a single test per chain:
+// at most one signal per idle period.
+#define PREWARM_HANDLER_PRI  51     // Before Intuition (50): raw mouse events
 
-static void daemon(void);
-static inline void daemon_TimerStart(ULONG micros);
-static inline void daemon_ProcessWheel(int delta);
-static inline void daemon_ProcessButtons(UWORD state);
-static inline ULONG daemon_GetAdaptiveInterval(BOOL hadActivity);
-static BOOL daemon_Init(void);
-static void daemon_Cleanup(void);
+typedef struct
+{
+    volatile UBYTE armed;      // Set by daemon while IDLE, cleared by handler
+    struct Task *task;         // Daemon task to signal
+    ULONG signal;              // Signal mask
+} PrewarmGate;
 
+#ifndef XMOUSED_HOST
+static PrewarmGate s_prewarmGate;
+static struct Interrupt s_prewarmInterrupt;
+static struct IOStdReq *s_prewarmReq = NULL;  // IND_ADDHANDLER/IND_REMHANDLER request
+static ULONG s_prewarmSignal = 0;  // Daemon signal mask (0 = handler off)
+static BYTE s_prewarmSigBit = -1;  // Allocated signal bit
+#endif
 
 //===========================================================================
-// Macros
+// CIA Sampling (gaming mode)
 //===========================================================================
 
-// Simple print macros
-#define Print(text) Printf(text "\n")
-#define PrintF(fmtText,...) Printf(fmtText "\n", __VA_ARGS__)
+// Options bit 9: a free CIA timer interrupts at 1-8kHz and reads $DFF212
+// once. Wheel movement is summed into a running total, button changes
+// are queued with the wheel total at that moment, so the daemon replays
+// them in order. The daemon is signalled on the first change after each
+// drain: everything latched until it runs is injected as one chain.
+// Replaces timer polling and VBL sampling (bit 3) while active.
+#define CIA_RATE_BASE_HZ     1000   // Rate index 0, doubled per index
+#define CIA_RATE_COUNT       4
+#define CIA_EDGE_RING_SIZE   32     // Button changes held between drains (power of 2)
+#define CIA_COST_WINDOW_US   100000 // Busy loop per rate in XMSG_CMD_BENCH_CIA
+#define CIAA_BASE            ((volatile struct CIA *)0xBFE001)
+#define CIAB_BASE            ((volatile struct CIA *)0xBFD000)
+
+#define CIA_RATE_HZ(index)   ((ULONG)CIA_RATE_BASE_HZ << (index))
+#define OPT_CIA_RATE(options) ((UBYTE)(((options) & OPT_CIA_RATE_MASK) >> OPT_CIA_RATE_SHIFT))
+
+typedef struct
+{
+    volatile ULONG wheelTotal;                          // Detents since start (wraps)
+    volatile UWORD edgeButtons[CIA_EDGE_RING_SIZE];     // Button state after each change
+    volatile ULONG edgeWheel[CIA_EDGE_RING_SIZE];       // wheelTotal at that change
+    volatile UBYTE head;       // Written by interrupt only
+    volatile UBYTE tail;       // Written by daemon only
+    volatile UBYTE signalled;  // Set by interrupt, cleared by daemon before draining
+    volatile UBYTE overflow;   // Ring was full: current state is pushed once there is room
+    volatile UWORD mask;       // Register bits watched (wheel/buttons enabled)
+    volatile ULONG samples;    // Interrupts taken (cost benchmark)
+    UWORD last;                // Last sample seen by interrupt
+    struct Task *task;         // Daemon task to signal
+    ULONG signal;              // Signal mask
+} CiaSampler;
+
+static CiaSampler s_ciaSampler;
+static ULONG s_ciaWheelTaken;                  // wheelTotal already injected (daemon only)
+#ifndef XMOUSED_HOST
+static struct Interrupt s_ciaInterrupt;
+static struct Library *s_ciaResource = NULL;   // Resource owning the timer (NULL = off)
+static volatile struct CIA *s_ciaHw;           // Its chip registers
+static UBYTE s_ciaTimerB;                      // TRUE: timer B, FALSE: timer A
+static ULONG s_ciaSignal = 0;  // Daemon signal mask (0 = CIA sampling off)
+static BYTE s_ciaSigBit = -1;  // Allocated signal bit
+
+// Interrupt sampling replaces the polling timer (VBL or CIA)
+#define SAMPLING_EVENT_DRIVEN() (s_vblSignal || s_ciaSignal)
+#endif
 
+// CPU cost benchmark result (XMSG_CMD_BENCH_CIA)
+#define CIA_COST_VERSION     1
+
+struct XMouseCiaCost
+{
+    UWORD version;                      // CIA_COST_VERSION (set by daemon)
+    UWORD size;                         // In: buffer size, out: bytes written
+    ULONG windowUs;                     // Busy loop length per rate
+    ULONG baseLoops;                    // Loop count without sampler
+    ULONG rateHz[CIA_RATE_COUNT];
+    ULONG samplesPerSec[CIA_RATE_COUNT];  // Interrupts actually taken
+    ULONG costPermille[CIA_RATE_COUNT];   // CPU lost to the sampler (0.1% units)
+};
 
 //===========================================================================
-// Debug Macros
+// Event Subscription
 //===========================================================================
 
-#ifndef RELEASE
-    // Log to debug console if debug mode enabled.
-    #define DebugLog(fmt) \
-        if (s_configByte & CONFIG_DEBUG_MODE) { \
-            BPTR _old = SelectOutput(s_debugCon); \
-            Printf(fmt "\n"); \
-            Flush(s_debugCon); \
-            SelectOutput(_old); \
-        }
+// XMSG_CMD_SUBSCRIBE registers a client MsgPort: each wheel delta and
+// button edge is sent there from the tick as a struct XMouseEvent, before
+// injection. Events come from a pool allocated at subscription, the client
+// gives each one back with ReplyMsg(). With the pool empty, events are
+// counted in 'dropped' of the next one sent. After XMSG_CMD_UNSUBSCRIBE is
+// replied, nothing more is sent, but events still queued on the client
+// port must be replied before the port is deleted.
+#define SUBSCRIBE_VERSION       1
+#define SUBSCRIBERS_MAX         4
+#define SUBSCRIBE_POOL_SIZE     16      // Events in flight per subscriber
+#define SUBSCRIBE_NO_INJECT     0x01    // Flag: no input.device injection while subscribed
+#define SUBSCRIBE_CODE_CLOSED   0xFFFF  // Last event: daemon stops, reply it and no unsubscribe needed
+#define SUBSCRIBE_ORPHAN_NAME   "XMouseD_Orphans" // Reply port left at exit with events still out
 
-    #define DebugLogF(fmt, ...) \
-        if (s_configByte & CONFIG_DEBUG_MODE) { \
-            BPTR _old = SelectOutput(s_debugCon); \
-            Printf(fmt "\n", __VA_ARGS__); \
-            Flush(s_debugCon); \
-            SelectOutput(_old); \
-        }
+struct XMouseSubscribe
+{
+    UWORD version;                  // SUBSCRIBE_VERSION (set by daemon)
+    UWORD size;                     // sizeof(struct XMouseSubscribe)
+    struct MsgPort *port;           // Client port, valid until unsubscribed
+    ULONG flags;                    // SUBSCRIBE_*
+};
+
+struct XMouseEvent
+{
+    struct Message msg;
+    UWORD code;                     // NM_WHEEL_UP/DOWN, NM_BUTTON_* (| IECODE_UP_PREFIX), SUBSCRIBE_CODE_CLOSED
+    WORD delta;                     // Wheel: signed detents, after acceleration (0 for buttons)
+    ULONG clock;                    // EClock (low 32 bits) when sent
+    ULONG dropped;                  // Events lost before this one (pool empty)
+};
+
+#ifndef XMOUSED_HOST
+typedef struct
+{
+    struct MsgPort *port;           // Client port (NULL = free or unsubscribed)
+    struct XMouseEvent *pool;       // SUBSCRIBE_POOL_SIZE events (NULL = slot free)
+    UBYTE freeList[SUBSCRIBE_POOL_SIZE];  // Indexes of events not sent
+    UBYTE freeCount;
+    UBYTE flags;                    // SUBSCRIBE_*
+    ULONG dropped;
+} Subscriber;
+
+// Event reply port, built by hand. If events are still out at exit it is
+// left behind as a public PA_IGNORE port named SUBSCRIBE_ORPHAN_NAME with
+// the pools it waits for; the next daemon (or this one at exit) frees
+// each pool once all its events are replied, then the port.
+typedef struct
+{
+    struct MsgPort port;
+    struct XMouseEvent *pool[SUBSCRIBERS_MAX];  // Orphaned pools (NULL = freed)
+    UBYTE outstanding[SUBSCRIBERS_MAX];         // Their events not replied yet
+} SubscribePort;
+
+static Subscriber s_subscribers[SUBSCRIBERS_MAX];
+static struct MsgPort *s_subscribePort = NULL;  // Event replies, a SubscribePort (NULL = no pool allocated)
+static ULONG s_subscribeSignal = 0;             // Its signal mask
+static UBYTE s_subscriberCount = 0;             // Subscribers with a port
+static UBYTE s_subscribeExclusive = 0;          // ...of which with SUBSCRIBE_NO_INJECT
+
+// TRUE if injection is left to subscribers
+#define SUBSCRIBE_POST(code, delta) (s_subscriberCount && subscribePost((code), (delta)))
 #else
-    #define DebugLog(fmt)         {} // No-op
-    #define DebugLogF(fmt, ...)   {} // No-op
+#define SUBSCRIBE_POST(code, delta) FALSE
 #endif
 
+//===========================================================================
+// Wheel Smoothing
+//===========================================================================
+
+// With OPT_WHEEL_SMOOTH, the detents read in one tick are not injected
+// as a burst: the first goes out at once, the others are spread evenly
+// over the next poll interval (or 1-3 frames, bits 14-15) by a MICROHZ
+// timer of their own. A single detent is never delayed.
+#define SMOOTH_SLOT_MIN_US      1000    // Shortest gap between two detents
 
+#ifndef XMOUSED_HOST
+static struct MsgPort *s_smoothPort = NULL;
+static struct timerequest *s_smoothReq = NULL;
+static ULONG s_smoothSignal = 0;        // Timer port signal (0 = smoothing off)
+static BOOL s_smoothBusy = FALSE;       // Timer request in flight
+static BOOL s_smoothRestart = FALSE;    // Detents added: open a new window on next arm
+static int s_smoothPending = 0;         // Detents not injected yet (+ = up)
+static ULONG s_smoothLeftUs = 0;        // Window time left for them
+
+// TRUE if the delta is left to the smoothing scheduler
+#define SMOOTH_WHEEL(delta) (s_smoothSignal && daemon_SmoothWheel(delta))
+#else
+#define SMOOTH_WHEEL(delta) FALSE
+#endif
+
+#if !defined(RELEASE) && !defined(XMOUSED_HOST)
 //===========================================================================
-// Main thread functions
+// Debug Log Ring
 //===========================================================================
 
-/**
- * Entry point.
- * Checks for existing instance and starts/stops daemon accordingly.
- * 
- * @return RETURN_OK on success, RETURN_FAIL on failure.
- */
-LONG _start(void)
+// DebugLog/DebugLogF only copy the format pointer and its arguments into
+// a single-producer/single-consumer ring. A low-priority logger process
+// owns the debug console and formats/flushes records between daemon
+// wakeups, so no console I/O runs in the poll loop. Formats and %s
+// arguments must stay valid until printed (literals, static tables).
+#define LOG_RING_SIZE        64     // Records held between drains (power of 2)
+#define LOG_ARGS_MAX         5      // Format arguments kept per record
+#define LOG_DRAIN_TICKS      5      // DOS ticks between drains (100ms)
+#define LOG_TASK_PRI         -5     // Below the daemon and applications
+#define LOG_TASK_NAME        PROGRAM_NAME" - Logger"
+#define LOG_CON_NAME         "CON:0/0/640/200/"PROGRAM_NAME" Debug/AUTO/CLOSE"
+
+typedef struct
 {
-    struct MsgPort *existingPort = NULL;
-    struct Process *proc = NULL;
-    struct CommandLineInterface *cli = NULL;
-    LONG exitCode = RETURN_OK;
-    
-    SysBase = *(struct ExecBase **)4L;
-    DOSBase = (struct DosLibrary *)OpenLibrary("dos.library", 36);
-    if (!DOSBase) { return RETURN_FAIL; }
+    const char *fmt;           // Format, newline included
+    ULONG args[LOG_ARGS_MAX];  // RawDoFmt argument array
+} LogRecord;
 
-    // check if should start or stop the daemon
-    BYTE startMode = parseArguments();
+typedef struct
+{
+    volatile LogRecord records[LOG_RING_SIZE];
+    volatile UBYTE head;       // Written by daemon only
+    volatile UBYTE tail;       // Written by logger only
+    volatile ULONG dropped;    // Records lost while ring was full (daemon only)
+    struct Task *logger;       // Logger process (NULL = debug output off)
+    struct Task *owner;        // Daemon, signalled when the logger exits
+    BYTE doneSigBit;           // Allocated signal bit for the exit handshake
+} LogRing;
 
-    // Check if XMouse is already running
-    Forbid();
-    existingPort = FindPort(DAEMON_PORT_NAME);
-    Permit();
+static LogRing s_logRing;
+#endif
 
-    if (startMode == START_MODE_STOP && !existingPort)
-    {
-        // Not running, nothing to do
-        Print(MSG_DAEMON_NOT_RUNNING);
-        goto cleanup;
-    }
+// XMouse control message
+struct XMouseMsg
+{
+    struct Message msg;
+    UBYTE command;      // XMSG_CMD_* 
+    ULONG value;        // Command parameter 
+    ULONG result;       // Result/status 
+};
 
-    if (startMode == START_MODE_STATUS || (startMode == START_MODE_START && existingPort))
-    {
-        ULONG status;
-        
-        if (!existingPort)
-        {
-            Print(MSG_DAEMON_NOT_RUNNING);
-            exitCode = RETURN_WARN;
-            goto cleanup;
-        }
-        
+//===========================================================================
+// Control Requests
+//===========================================================================
+
+// An XMouseMsg with command XMSG_CMD_REQUEST carries a batch of commands
+// as tags (tag = XMSG_CMD_*, data = value), executed in order in one
+// round trip; the first failing tag or a QUIT tag ends the batch. 'id'
+// is returned unchanged, so replies of several requests in flight on one
+// reply port can be matched. Older daemons answer 0xFFFFFFFF (unknown
+// command): single commands are then resent as plain XMouseMsg.
+//
+// The reply is the only completion notice: a client that must stay
+// responsive waits for its reply port along with its other signals.
+// Requests must come from AllocMem() with mn_Length = allocated size:
+// the daemon frees them itself when the client gave up, or when asked
+// not to reply. 'state' is changed under Forbid() by both sides: a
+// client may abandon a QUEUED request; a RUNNING one may still write
+// to buffers named by its tags, so it is always waited for.
+#define XMREQ_VERSION           1
+#define XMREQ_TAGS_MAX          8
+#define XMREQ_STATE_QUEUED      0   // Sent, not taken by the daemon yet
+#define XMREQ_STATE_RUNNING     1   // Being executed: wait for the reply
+#define XMREQ_STATE_DONE        2   // Replied
+#define XMREQ_STATE_ABANDONED   3   // Client gave up: freed unexecuted by the daemon
+#define XMREQ_FLAG_NOREPLY      0x01  // Freed by the daemon after execution (no reply)
+#define XMREQ_UNSUPPORTED       0xFFFFFFFE  // sendDaemonRequest(): daemon predates tag requests
+
+struct XMouseTag
+{
+    ULONG tag;          // XMSG_CMD_* (not XMSG_CMD_REQUEST)
+    ULONG data;         // Command value (GET_TIMING: requested mean us on return)
+    ULONG result;       // Command result, 0xFFFFFFFF if failed or not executed
+};
+
+struct XMouseRequest
+{
+    struct XMouseMsg header;        // command = XMSG_CMD_REQUEST, result = tags done
+    UWORD version;                  // In: XMREQ_VERSION, out: daemon's
+    UWORD size;                     // sizeof(struct XMouseRequest)
+    ULONG id;                       // Client request ID, returned unchanged
+    volatile UBYTE state;           // XMREQ_STATE_*
+    UBYTE flags;                    // XMREQ_FLAG_*
+    UWORD count;                    // Tags used
+    struct XMouseTag tags[XMREQ_TAGS_MAX];
+};
+
+// User profile upload (XMSG_CMD_SET_PROFILE), owned by the sender until reply
+struct XMouseProfile
+{
+    UBYTE slot;                     // User slot 0-3 (config bit 3 + bits 4-5)
+    UBYTE accelCurve;               // ACCEL_CURVE_*
+    char name[PROFILE_NAME_MAX];    // Shown as mode name (NUL terminated)
+    ULONG idleUs;                   // Same fields and rules as AdaptiveMode
+    ULONG activeUs;
+    ULONG burstUs;
+    ULONG stepDecUs;
+    ULONG stepIncUs;
+    ULONG activeThreshold;
+    ULONG idleThreshold;
+};
+
+//===========================================================================
+// Statistics
+//===========================================================================
+
+// Counters kept in every build (increments, one EClock read per tick),
+// copied into the sender's buffer by XMSG_CMD_GET_STATS. Clients set
+// 'size' to their buffer size: the daemon copies at most that many bytes,
+// so older clients keep working when fields are appended.
+#define XMOUSE_STATS_VERSION    1
+#define STATS_HISTOGRAM_BUCKETS 16      // Bucket n: 2^n <= EClock ticks < 2^(n+1), last open-ended
+#define STATS_CLASS_WHEEL       0
+#define STATS_CLASS_BUTTONS     1
+
+struct XMouseStats
+{
+    UWORD version;                  // XMOUSE_STATS_VERSION (set by daemon)
+    UWORD size;                     // In: buffer size, out: bytes written
+    ULONG eclockFreq;               // EClock frequency (histogram unit)
+    ULONG ticks;                    // Timer ticks processed
+    ULONG wakeups;                  // Daemon wakeups (any signal)
+    ULONG submits;                  // IND_WRITEEVENT requests
+    ULONG events[2];                // Events injected per STATS_CLASS_*
+    ULONG stateSecs[4];             // Time per POLL_STATE_*: seconds...
+    ULONG stateMicros[4];           // ...and microseconds (adaptive engines)
+    ULONG intervalUs;               // Current poll interval (0 = VBL sampling)
+    ULONG maxWheelDelta;            // Largest wheel delta of one tick (detents, before acceleration)
+    ULONG histogram[STATS_HISTOGRAM_BUCKETS]; // Tick processing time (wake to reschedule)
+};
+
+// Live block published through the public port (struct XMousePort).
+// Monitors read it in place: 'sequence' is odd while the daemon handles
+// a wakeup, a copy is consistent if the same even value is read before
+// and after it. Only the daemon writes.
+#define XMOUSE_PORT_MAGIC       0x584D5350  // 'XMSP'
+#define XMOUSE_SHARED_VERSION   1
+
+struct XMouseShared
+{
+    volatile ULONG sequence;        // Odd while the daemon updates the block
+    UWORD version;                  // XMOUSE_SHARED_VERSION
+    UWORD size;                     // sizeof(struct XMouseShared)
+    UBYTE config;                   // Config byte
+    UBYTE state;                    // POLL_STATE_*
+    UWORD reserved;
+    ULONG options;                  // Options word
+    struct XMouseStats stats;       // Counters, intervalUs kept live
+};
+
+// Public port: FindPort(DAEMON_PORT_NAME) returns this structure
+struct XMousePort
+{
+    struct MsgPort port;
+    ULONG magic;                    // XMOUSE_PORT_MAGIC
+    struct XMouseShared *shared;    // Read-only for clients, valid while the port exists
+};
+
+static struct XMouseShared s_shared;
+
+//===========================================================================
+// Cycle Profiler
+//===========================================================================
+
+// Built with -DCYCLE_PROFILER (make MODE=cycles), otherwise the macros
+// are empty and XMSG_CMD_GET_CYCLES fails. Each phase of a timer tick is
+// bracketed by EClock reads; the read closing a phase opens the next one,
+// so the profiler's own cost is spread over the phases it measures.
+// Same copy rules as XMSG_CMD_GET_STATS ('size').
+#define CYCLES_VERSION              1
+#define CYCLES_PHASE_READ           0   // Wheel counter and buttons register reads
+#define CYCLES_PHASE_QUALIFIER      1   // PeekQualifier() in injectBegin()
+#define CYCLES_PHASE_INJECT         2   // Event chain build and submit
+#define CYCLES_PHASE_ADAPT          3   // Interval update and timer restart
+#define CYCLES_PHASE_COUNT          4
+#define CYCLES_HISTOGRAM_BUCKETS    8   // Bucket n: EClock ticks < 2^(n+1), last open-ended
+
+struct XMouseCyclePhase
+{
+    ULONG count;                    // Samples
+    ULONG min;                      // EClock ticks
+    ULONG max;
+    ULONG total;                    // Mean = total / count
+    ULONG histogram[CYCLES_HISTOGRAM_BUCKETS];
+};
+
+struct XMouseCycles
+{
+    UWORD version;                  // CYCLES_VERSION (set by daemon)
+    UWORD size;                     // In: buffer size, out: bytes written
+    ULONG eclockFreq;               // EClock frequency (time unit)
+    struct XMouseCyclePhase phases[CYCLES_PHASE_COUNT];
+};
+
+#ifndef XMOUSED_HOST
+static const char *s_cyclePhaseNames[CYCLES_PHASE_COUNT] = { "read", "qualifier", "inject", "adapt" };
+#endif
+
+#ifdef CYCLE_PROFILER
+    static struct XMouseCycles s_cycles;
+    #define CYCLES_START(clock)         clock = daemon_CyclesClock()
+    #define CYCLES_PHASE(phase, clock)  clock = daemon_CyclesAdd(phase, clock)
+#else
+    #define CYCLES_START(clock)         {} // No-op
+    #define CYCLES_PHASE(phase, clock)  {} // No-op
+#endif
+
+#ifndef RELEASE
+    static ULONG s_pollCount = 0;
+    static UWORD s_maxTickSubmits = 0;  // Highest submissions count seen in one tick
+    static ULONG s_droppedButtons = 0;  // Button codes lost while ring was full
+#endif
+
+// Version string - uses APP_* macros
+const char version[] = VERSION_STRING;
+
+
+//===========================================================================
+// Function Prototypes
+//===========================================================================
+
+static inline int parseHexDigit(UBYTE c);
+static inline const char* getModeName(UBYTE configByte);
+static inline ULONG parseDecimal(UBYTE **p);
+static inline const AdaptiveMode *daemon_ModeOf(UBYTE configByte);
+static inline BOOL daemon_ProfileCheck(const AdaptiveMode *mode);
+static BOOL daemon_ProfileSet(const struct XMouseProfile *profile);
+static inline void daemon_ApplyMode(void);
+static inline void daemon_ClockInit(ULONG freq);
+
+static inline void daemon_TickBody(UBYTE features, UBYTE engine);
+static inline void daemon_TickSelect(void);
+#define TICK_PROTO(name, features, engine) static void daemon_Tick##name(void);
+TICK_VARIANTS(TICK_PROTO)
+static inline void daemon_TimerStart(ULONG micros);
+static inline void daemon_TimerNext(ULONG micros);
+static inline ULONG daemon_TimerTicks(ULONG micros);
+static inline ULONG daemon_ClockSince(const struct EClockVal *from, const struct EClockVal *to);
+static inline void daemon_TimerMeasure(void);
+static inline ULONG daemon_TimerAchievedUs(UBYTE unit);
+static inline void injectBegin(void);
+static inline BOOL injectReserve(UWORD count);
+static inline struct InputEvent *injectQueue(UBYTE ieClass, UWORD code);
+static inline void injectWheel(int delta);
+static inline void injectButton(UWORD code);
+static inline void injectFlush(void);
+static inline void injectReap(void);
+static inline void injectDrain(void);
+static inline UWORD daemon_SampleMask(void);
+static inline void daemon_VblTick(void);
+static inline void daemon_CiaTick(void);
+static inline void daemon_DecodeSample(UWORD raw, MouseSample *sample);
+static inline int daemon_WheelDelta(BYTE counter);
+static inline int daemon_AccelerateWheel(int delta);
+static inline void daemon_ProcessWheel(int delta);
+static inline void daemon_ProcessButtons(UWORD state);
+static inline ULONG daemon_GetAdaptiveInterval(BOOL hadActivity);
+static inline ULONG daemon_GetPredictiveInterval(BOOL hadActivity);
+static inline void daemon_StatsState(ULONG micros);
+static inline void daemon_StatsTick(ULONG startClock);
+#ifdef CYCLE_PROFILER
+static inline ULONG daemon_CyclesClock(void);
+static inline ULONG daemon_CyclesAdd(UBYTE phase, ULONG startClock);
+#endif
+static void daemon_LadderBuild(const AdaptiveMode *mode);
+static void daemon_LadderFill(AdaptiveStep *ladder, UBYTE *last, ULONG from, ULONG to, ULONG step);
+static inline void daemon_TraceSample(UWORD raw, ULONG clock);
+static void daemon_TraceDrain(void);
+static inline void daemon_TraceRecord(UWORD type, UWORD value, ULONG clock);
+
+// OS-only (not part of the host simulator build)
+#ifndef XMOUSED_HOST
+static ULONG sendDaemonRequest(struct MsgPort *port, struct XMouseTag *tags, UWORD count);
+static ULONG sendDaemonMessage(struct MsgPort *port, UBYTE cmd, ULONG value);
+static ULONG sendDaemonPlain(struct MsgPort *port, UBYTE cmd, ULONG value);
+static BOOL readShared(struct XMouseShared *snap);
+static inline BYTE parseArguments(void);
+static void daemon_Command(struct XMouseMsg *msg, BOOL *quit);
+static void daemon_Request(struct XMouseRequest *req, BOOL *quit);
+static void daemon(void);
+static BOOL daemon_TimerOpen(UBYTE unit);
+static inline void daemon_SetOptions(ULONG options);
+static BOOL daemon_VblStart(void);
+static void daemon_VblStop(void);
+static BOOL daemon_CiaStart(UBYTE rate);
+static void daemon_CiaStop(void);
+static void daemon_SamplingApply(ULONG options);
+static ULONG daemon_BenchCia(struct XMouseCiaCost *cost);
+static ULONG subscribeAdd(struct XMouseSubscribe *sub);
+static ULONG subscribeRemove(struct MsgPort *port);
+static BOOL subscribePost(UWORD code, WORD delta);
+static void subscribeReap(void);
+static void subscribeStop(void);
+static void subscribeOrphansReap(void);
+static struct MsgPort *subscribePortCreate(void);
+static BOOL daemon_PrewarmStart(void);
+static void daemon_PrewarmStop(void);
+static void daemon_Prewarm(void);
+static BOOL daemon_SmoothStart(void);
+static void daemon_SmoothStop(void);
+static BOOL daemon_SmoothWheel(int delta);
+static void daemon_SmoothArm(void);
+static void daemon_SmoothTick(void);
+static BOOL injectHandlerStart(void);
+static void injectHandlerStop(void);
+static void injectKick(void);
+static void injectHandlerRelease(void);
+static ULONG daemon_BenchLatency(struct XMouseLatency *lat);
+static UWORD daemon_TraceSource(void);
+static void daemon_TraceSamplerUpdate(void);
+static void daemon_TraceSamplerStop(void);
+static void daemon_TraceStart(void);
+static void daemon_TraceStop(void);
+static void daemon_ProfileLoad(void);
+static BOOL daemon_PortCreate(void);
+static void daemon_PortDelete(void);
+#ifndef RELEASE
+static void debugLogPush(const char *fmt, ...);
+static void daemon_Logger(void);
+static void daemon_LogStart(void);
+static void daemon_LogStop(void);
+#endif
+static BOOL daemon_Init(void);
+static void daemon_Cleanup(void);
+#endif
+
+
+//===========================================================================
+// Macros
+//===========================================================================
+
+// Simple print macros
+#define Print(text) Printf(text "\n")
+#define PrintF(fmtText,...) Printf(fmtText "\n", __VA_ARGS__)
+
+
+//===========================================================================
+// Debug Macros
+//===========================================================================
+
+#if !defined(RELEASE) && !defined(XMOUSED_HOST)
+    // Queue a record for the logger process if debug mode enabled.
+    #define DebugLog(fmt) \
+        if ((s_configByte & CONFIG_DEBUG_MODE) && s_logRing.logger) { \
+            debugLogPush(fmt "\n"); \
+        }
+
+    #define DebugLogF(fmt, ...) \
+        if ((s_configByte & CONFIG_DEBUG_MODE) && s_logRing.logger) { \
+            debugLogPush(fmt "\n", __VA_ARGS__); \
+        }
+#else
+    #define DebugLog(fmt)         {} // No-op
+    #define DebugLogF(fmt, ...)   {} // No-op
+#endif
+
+
+#ifndef XMOUSED_HOST
+//===========================================================================
+// Main thread functions
+//===========================================================================
+
+/**
+ * Entry point.
+ * Checks for existing instance and starts/stops daemon accordingly.
+ * 
+ * @return RETURN_OK on success, RETURN_FAIL on failure.
+ */
+LONG _start(void)
+{
+    struct MsgPort *existingPort = NULL;
+    struct Process *proc = NULL;
+    struct CommandLineInterface *cli = NULL;
+    LONG exitCode = RETURN_OK;
+    
+    SysBase = *(struct ExecBase **)4L;
+    DOSBase = (struct DosLibrary *)OpenLibrary("dos.library", 36);
+    if (!DOSBase) { return RETURN_FAIL; }
+
+    // check if should start or stop the daemon
+    BYTE startMode = parseArguments();
+
+    // Check if XMouse is already running
+    Forbid();
+    existingPort = FindPort(DAEMON_PORT_NAME);
+    Permit();
+
+    if (startMode == START_MODE_STOP && !existingPort)
+    {
+        // Not running, nothing to do
+        Print(MSG_DAEMON_NOT_RUNNING);
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_STATUS || (startMode == START_MODE_START && existingPort))
+    {
+        ULONG status;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
         // Query daemon status - result is config byte
         status = sendDaemonMessage(existingPort, XMSG_CMD_GET_STATUS, 0);
         
-        if (status != 0xFFFFFFFF)
+        if (status != 0xFFFFFFFF)
+        {
+            PrintF(MSG_DAEMON_RUNNING, status);
+            
+            status = sendDaemonMessage(existingPort, XMSG_CMD_GET_OPTIONS, 0);
+            if (status != 0xFFFFFFFF)
+            {
+                PrintF(MSG_DAEMON_OPTIONS, status);
+            }
+        }
+        else
+        {
+            Print(MSG_ERR_GET_STATUS_FAILED);
+            exitCode = RETURN_FAIL;
+        }
+        
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_TIMING)
+    {
+        UBYTE unit;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        // Requested vs. achieved mean interval for each timer unit
+        for (unit = 0; unit < TIMER_UNIT_COUNT; unit++)
+        {
+            ULONG achieved = sendDaemonMessage(existingPort, XMSG_CMD_GET_TIMING, unit);
+            
+            if (achieved == 0xFFFFFFFF)
+            {
+                Print(MSG_ERR_GET_TIMING_FAILED);
+                exitCode = RETURN_FAIL;
+                break;
+            }
+            if (achieved == 0)
+            {
+                PrintF(MSG_TIMING_NONE, (ULONG)s_timerUnitNames[unit]);
+            }
+            else
+            {
+                PrintF(MSG_TIMING_LINE, (ULONG)s_timerUnitNames[unit], s_replyValue, achieved);
+            }
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_STATS)
+    {
+        struct XMouseStats stats;
+        UBYTE i;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        stats.size = sizeof(stats);
+        if (sendDaemonMessage(existingPort, XMSG_CMD_GET_STATS, (ULONG)&stats) == 0xFFFFFFFF)
+        {
+            Print(MSG_ERR_GET_STATS_FAILED);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        PrintF(MSG_STATS_COUNTERS, stats.ticks, stats.wakeups, stats.submits);
+        PrintF(MSG_STATS_EVENTS, stats.events[STATS_CLASS_WHEEL], stats.events[STATS_CLASS_BUTTONS],
+               stats.maxWheelDelta);
+        PrintF(MSG_STATS_INTERVAL, (LONG)stats.intervalUs);
+        
+        for (i = 0; i < 4; i++)
+        {
+            PrintF(MSG_STATS_STATE, (ULONG)s_pollStateNames[i], stats.stateSecs[i], stats.stateMicros[i] / 1000);
+        }
+        
+        // Upper bound of each bucket in microseconds
+        for (i = 0; i < STATS_HISTOGRAM_BUCKETS && stats.eclockFreq >= 1000; i++)
+        {
+            if (stats.histogram[i])
+            {
+                PrintF(MSG_STATS_BUCKET, (LONG)((2000UL << i) / (stats.eclockFreq / 1000)), stats.histogram[i]);
+            }
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_CYCLES)
+    {
+        struct XMouseCycles cycles;
+        struct XMouseCyclePhase *p;
+        ULONG mean, frac;
+        UBYTE i, b;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        cycles.size = sizeof(cycles);
+        if (sendDaemonMessage(existingPort, XMSG_CMD_GET_CYCLES, (ULONG)&cycles) == 0xFFFFFFFF)
+        {
+            Print(MSG_ERR_GET_CYCLES_FAILED);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        PrintF(MSG_CYCLES_HEADER, cycles.eclockFreq);
+        for (i = 0; i < CYCLES_PHASE_COUNT; i++)
+        {
+            p = &cycles.phases[i];
+            mean = p->count ? p->total / p->count : 0;
+            frac = p->count ? ((p->total % p->count) * 100) / p->count : 0;
+            PrintF(MSG_CYCLES_LINE, (ULONG)s_cyclePhaseNames[i], p->count, p->min, mean, frac, p->max);
+            
+            // Upper bound of each bucket in EClock ticks
+            for (b = 0; b < CYCLES_HISTOGRAM_BUCKETS; b++)
+            {
+                if (p->histogram[b] && b == CYCLES_HISTOGRAM_BUCKETS - 1)
+                {
+                    PrintF(MSG_CYCLES_BUCKET_LAST, 1UL << b, p->histogram[b]);
+                }
+                else if (p->histogram[b])
+                {
+                    PrintF(MSG_CYCLES_BUCKET, 2UL << b, p->histogram[b]);
+                }
+            }
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_WATCH)
+    {
+        struct XMouseSubscribe sub;
+        struct XMouseEvent *ev;
+        struct MsgPort *port;
+        ULONG signals = 0;
+        BOOL closed = FALSE;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        port = CreateMsgPort();
+        sub.size = sizeof(sub);
+        sub.port = port;
+        sub.flags = 0;
+        if (!port || sendDaemonMessage(existingPort, XMSG_CMD_SUBSCRIBE, (ULONG)&sub) == 0xFFFFFFFF)
+        {
+            if (port)
+            {
+                DeleteMsgPort(port);
+            }
+            Print(MSG_ERR_SUBSCRIBE_FAILED);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        Print(MSG_WATCH_HEADER);
+        // Events already queued are shown before CTRL-C is acted on
+        while (!closed && !(signals & SIGBREAKF_CTRL_C))
+        {
+            signals = Wait((1L << port->mp_SigBit) | SIGBREAKF_CTRL_C);
+            while ((ev = (struct XMouseEvent *)GetMsg(port)))
+            {
+                if (ev->dropped)
+                {
+                    PrintF(MSG_WATCH_DROPPED, ev->clock, ev->dropped);
+                }
+                if (ev->code == SUBSCRIBE_CODE_CLOSED)
+                {
+                    Print(MSG_WATCH_CLOSED);
+                    closed = TRUE;
+                }
+                else if ((ev->code & ~IECODE_UP_PREFIX) >= NM_BUTTON_FOURTH)
+                {
+                    PrintF(MSG_WATCH_BUTTON, ev->clock,
+                           (LONG)(((ev->code & ~IECODE_UP_PREFIX) == NM_BUTTON_FOURTH) ? 4 : 5),
+                           (ev->code & IECODE_UP_PREFIX) ? "release" : "press");
+                }
+                else
+                {
+                    PrintF(MSG_WATCH_WHEEL, ev->clock, (ev->delta > 0) ? "up" : "down",
+                           (LONG)((ev->delta > 0) ? ev->delta : -ev->delta));
+                }
+                ReplyMsg((struct Message *)ev);
+            }
+        }
+        
+        if (!closed)
+        {
+            // The daemon may have quit while watching: look its port up again
+            Forbid();
+            existingPort = FindPort(DAEMON_PORT_NAME);
+            Permit();
+            if (existingPort)
+            {
+                sendDaemonMessage(existingPort, XMSG_CMD_UNSUBSCRIBE, (ULONG)port);
+            }
+        }
+        
+        // Events sent before the reply are still queued: give them back
+        while ((ev = (struct XMouseEvent *)GetMsg(port)))
+        {
+            ReplyMsg((struct Message *)ev);
+        }
+        DeleteMsgPort(port);
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_CIACOST)
+    {
+        struct XMouseCiaCost cost;
+        UBYTE i;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        cost.size = sizeof(cost);
+        if (sendDaemonMessage(existingPort, XMSG_CMD_BENCH_CIA, (ULONG)&cost) == 0xFFFFFFFF)
+        {
+            Print(MSG_ERR_CIACOST_FAILED);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        PrintF(MSG_CIACOST_HEADER, cost.windowUs / 1000);
+        for (i = 0; i < CIA_RATE_COUNT; i++)
+        {
+            PrintF(MSG_CIACOST_LINE, cost.rateHz[i], cost.samplesPerSec[i],
+                   cost.costPermille[i] / 10, cost.costPermille[i] % 10);
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_LATENCY)
+    {
+        struct XMouseLatency lat;
+        ULONG khz;
+        UBYTE i;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        lat.size = sizeof(lat);
+        if (sendDaemonMessage(existingPort, XMSG_CMD_BENCH_LATENCY, (ULONG)&lat) == 0xFFFFFFFF || lat.eclockFreq < 1000)
+        {
+            Print(MSG_ERR_LATENCY_FAILED);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        khz = lat.eclockFreq / 1000;
+        PrintF(MSG_LATENCY_HEADER, lat.rounds);
+        for (i = 0; i < LATENCY_PATH_COUNT; i++)
+        {
+            PrintF(MSG_LATENCY_LINE, (ULONG)s_latencyPathNames[i],
+                   (LONG)(lat.min[i] * 1000 / khz), (LONG)(lat.mean[i] * 1000 / khz), (LONG)(lat.max[i] * 1000 / khz));
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_TOP)
+    {
+        struct XMouseShared snap;
+        ULONG prevTicks = 0, prevWakeups = 0, prevEvents = 0;
+        BOOL first = TRUE;
+        
+        if (!existingPort)
+        {
+            Print(MSG_DAEMON_NOT_RUNNING);
+            exitCode = RETURN_WARN;
+            goto cleanup;
+        }
+        
+        Print(MSG_TOP_HEADER);
+        while (!(CheckSignal(SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C))
+        {
+            if (!readShared(&snap))
+            {
+                Print(MSG_DAEMON_NOT_RUNNING);
+                break;
+            }
+            
+            // First line has no previous sample: rates start on the second
+            if (!first)
+            {
+                PrintF(MSG_TOP_LINE, (ULONG)snap.config, snap.options,
+                       (ULONG)s_pollStateNames[snap.state & 3], (LONG)snap.stats.intervalUs,
+                       (LONG)(snap.stats.ticks - prevTicks), (LONG)(snap.stats.wakeups - prevWakeups),
+                       (LONG)(snap.stats.events[STATS_CLASS_WHEEL] + snap.stats.events[STATS_CLASS_BUTTONS] - prevEvents),
+                       snap.stats.submits, snap.stats.maxWheelDelta);
+            }
+            first = FALSE;
+            prevTicks = snap.stats.ticks;
+            prevWakeups = snap.stats.wakeups;
+            prevEvents = snap.stats.events[STATS_CLASS_WHEEL] + snap.stats.events[STATS_CLASS_BUTTONS];
+            
+            Delay(TOP_REFRESH_TICKS);
+        }
+        goto cleanup;
+    }
+
+    if (startMode == START_MODE_CONFIG && existingPort)
+    {
+        struct XMouseTag tags[2];
+        UWORD count = 1;
+        ULONG done;
+        
+        // Config and options in one round trip
+        tags[0].tag = XMSG_CMD_SET_CONFIG;
+        tags[0].data = s_configByte;
+        if (s_optionsSet)
+        {
+            tags[1].tag = XMSG_CMD_SET_OPTIONS;
+            tags[1].data = s_options;
+            count = 2;
+        }
+        
+        done = sendDaemonRequest(existingPort, tags, count);
+        if (done == XMREQ_UNSUPPORTED)
+        {
+            // Older daemon: one plain message per command
+            for (done = 0; done < count; done++)
+            {
+                if (sendDaemonPlain(existingPort, (UBYTE)tags[done].tag, tags[done].data) == 0xFFFFFFFF)
+                {
+                    break;
+                }
+            }
+        }
+        if (done != 0xFFFFFFFF && done >= 1)
+        {
+            // Always log in dev builds
+            PrintF(MSG_CONFIG_UPDATED, (ULONG)s_configByte);
+        }
+        else
+        {
+            Print(MSG_ERR_UPDATE_CONFIG);
+            exitCode = RETURN_FAIL;
+            goto cleanup;
+        }
+        
+        if (s_optionsSet)
+        {
+            if (done == 2)
+            {
+                PrintF(MSG_OPTIONS_UPDATED, s_options);
+            }
+            else
+            {
+                Print(MSG_ERR_UPDATE_OPTIONS);
+                exitCode = RETURN_FAIL;
+            }
+        }
+        goto cleanup;
+    }
+    
+    if ((startMode == START_MODE_STOP || startMode == START_MODE_TOGGLE) && existingPort)
+    {
+        ULONG result;
+        
+        // Send QUIT message to daemon
+        result = sendDaemonMessage(existingPort, XMSG_CMD_QUIT, 0);
+        
+        if (result == 0)
+        {
+            Print(MSG_DAEMON_STOPPED);
+        }
+        else
+        {
+            Print(MSG_ERR_STOP_DAEMON);
+            exitCode = RETURN_FAIL;
+        }
+        goto cleanup;
+    }
+
+    // Create background process using WBM pattern
+    if (CreateNewProcTags(
+        NP_Entry, (ULONG)daemon,
+        NP_Name, (ULONG)DAEMON_DESC_SHORT,
+        NP_Priority, 0,
+        TAG_DONE))
+    {
+        // Detach from shell by clearing CLI module - WBM pattern
+        proc = (struct Process *)FindTask(NULL);
+        if (proc->pr_CLI)
+        {
+            cli = BADDR(proc->pr_CLI);
+            cli->cli_Module = 0;
+        }
+
+        // Start the daemon
+        PrintF(MSG_DAEMON_RUNNING, (ULONG)s_configByte);
+        if (s_options != DEFAULT_OPTIONS)
+        {
+            PrintF(MSG_DAEMON_OPTIONS, s_options);
+        }
+
+        goto cleanup;
+    }
+    
+    Print(MSG_DAEMON_START_FAILED);
+    exitCode = RETURN_FAIL;
+
+cleanup:
+    if (DOSBase)
+    {
+        CloseLibrary((struct Library *)DOSBase);
+    }
+    return exitCode;
+}
+
+/**
+ * Send a tag request to the daemon and wait for reply with timeout.
+ * On timeout the request is abandoned if the daemon has not taken it yet
+ * (the daemon frees it unexecuted). Once taken, the reply is always
+ * awaited: the daemon never writes to memory the caller released.
+ * @param port Daemon's public port
+ * @param tags Commands to execute in order, data and results updated
+ * @param count Number of tags (XMREQ_TAGS_MAX max)
+ * @return Tags executed successfully, XMREQ_UNSUPPORTED if the daemon
+ *         rejected the request itself, 0xFFFFFFFF on timeout/error
+ */
+static ULONG sendDaemonRequest(struct MsgPort *port, struct XMouseTag *tags, UWORD count)
+{
+    static ULONG requestId = 0;
+    struct MsgPort *replyPort = NULL;
+    struct XMouseRequest *req = NULL;
+    struct MsgPort *timerPort = NULL;
+    struct timerequest *timerReq = NULL;
+    ULONG result = 0xFFFFFFFF;  // Error by default
+    BOOL timerSent = FALSE;
+    BOOL abandoned = FALSE;
+    
+    if (count > XMREQ_TAGS_MAX)
+    {
+        return result;
+    }
+    
+    // Create reply port
+    replyPort = CreateMsgPort();
+    if (!replyPort)
+    {
+        goto cleanup;
+    }
+    
+    // Create timer for timeout (2 seconds)
+    timerPort = CreateMsgPort();
+    if (!timerPort)
+    {
+        goto cleanup;
+    }
+    timerReq = (struct timerequest *)CreateIORequest(timerPort, sizeof(struct timerequest));
+    if (!timerReq)
+    {
+        goto cleanup;
+    }
+    if (OpenDevice(TIMERNAME, UNIT_VBLANK, (struct IORequest *)timerReq, 0))
+    {
+        goto cleanup;
+    }
+    
+    // Allocate request (freed by the daemon if abandoned)
+    req = (struct XMouseRequest *)AllocMem(sizeof(struct XMouseRequest), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!req)
+    {
+        goto cleanup;
+    }
+    
+    // Setup request
+    req->header.msg.mn_Node.ln_Type = NT_MESSAGE;
+    req->header.msg.mn_Length = sizeof(struct XMouseRequest);
+    req->header.msg.mn_ReplyPort = replyPort;
+    req->header.command = XMSG_CMD_REQUEST;
+    req->version = XMREQ_VERSION;
+    req->size = sizeof(struct XMouseRequest);
+    req->id = ++requestId;
+    req->state = XMREQ_STATE_QUEUED;
+    req->count = count;
+    CopyMem(tags, req->tags, count * sizeof(struct XMouseTag));
+    
+    // Send request to daemon
+    PutMsg(port, (struct Message *)req);
+    
+    // Setup timeout: 2 seconds
+    timerReq->tr_node.io_Command = TR_ADDREQUEST;
+    timerReq->tr_time.tv_secs = DAEMON_REPLY_TIMEOUT;
+    timerReq->tr_time.tv_micro = 0;
+    SendIO((struct IORequest *)timerReq);
+    timerSent = TRUE;
+    
+    // Wait for reply OR timeout
+    Wait((1L << replyPort->mp_SigBit) | (1L << timerPort->mp_SigBit));
+    
+    if (!GetMsg(replyPort))
+    {
+        // Timeout: give up, unless the daemon is already executing it
+        Forbid();
+        if (req->state == XMREQ_STATE_QUEUED)
+        {
+            req->state = XMREQ_STATE_ABANDONED;
+            abandoned = TRUE;
+        }
+        Permit();
+        
+        if (abandoned)
+        {
+            Print(MSG_ERR_DAEMON_TIMEOUT);
+            req = NULL;  // Daemon's now
+            goto cleanup;
+        }
+        
+        WaitPort(replyPort);
+        GetMsg(replyPort);
+    }
+    
+    // Current daemons answer the number of tags done (0..count)
+    result = (req->header.result > count) ? XMREQ_UNSUPPORTED : req->header.result;
+    CopyMem(req->tags, tags, count * sizeof(struct XMouseTag));
+
+cleanup:
+    // Cleanup resources (safe even if NULL)
+    if (req)
+    {
+        FreeMem(req, sizeof(struct XMouseRequest));
+    }
+    if (timerReq)
+    {
+        if (timerSent)
+        {
+            if (!CheckIO((struct IORequest *)timerReq))
+            {
+                AbortIO((struct IORequest *)timerReq);
+            }
+            WaitIO((struct IORequest *)timerReq);
+        }
+        if (timerReq->tr_node.io_Device)
+        {
+            CloseDevice((struct IORequest *)timerReq);
+        }
+        DeleteIORequest((struct IORequest *)timerReq);
+    }
+    if (timerPort)
+    {
+        DeleteMsgPort(timerPort);
+    }
+    if (replyPort)
+    {
+        // Never replied to once abandoned
+        DeleteMsgPort(replyPort);
+    }
+    
+    return result;
+}
+
+/**
+ * Send one command to the daemon and wait for reply with timeout.
+ * Sent as a one-tag request (safe to abandon), resent as a plain
+ * XMouseMsg if the daemon predates tag requests.
+ * The command's value on return is kept in s_replyValue.
+ * @param port Daemon's public port
+ * @param cmd Command to send
+ * @param value Command parameter
+ * @return Command result, 0xFFFFFFFF on timeout/error
+ */
+static ULONG sendDaemonMessage(struct MsgPort *port, UBYTE cmd, ULONG value)
+{
+    struct XMouseTag tag;
+    ULONG done;
+    
+    tag.tag = cmd;
+    tag.data = value;
+    tag.result = 0xFFFFFFFF;
+    
+    done = sendDaemonRequest(port, &tag, 1);
+    if (done == XMREQ_UNSUPPORTED)
+    {
+        return sendDaemonPlain(port, cmd, value);
+    }
+    if (done == 0xFFFFFFFF)
+    {
+        return 0xFFFFFFFF;
+    }
+    s_replyValue = tag.data;
+    
+    return tag.result;
+}
+
+/**
+ * Send one command as a plain XMouseMsg (daemons without tag requests)
+ * and wait for reply with timeout. A plain message can't be abandoned:
+ * on timeout the message and its reply port are left allocated, the
+ * port set to PA_IGNORE, so a late reply touches no freed memory.
+ * The command's value on return is kept in s_replyValue.
+ * @param port Daemon's public port
+ * @param cmd Command to send
+ * @param value Command parameter
+ * @return Command result, 0xFFFFFFFF on timeout/error
+ */
+static ULONG sendDaemonPlain(struct MsgPort *port, UBYTE cmd, ULONG value)
+{
+    struct MsgPort *replyPort = NULL;
+    struct XMouseMsg *msg = NULL;
+    struct MsgPort *timerPort = NULL;
+    struct timerequest *timerReq = NULL;
+    ULONG result = 0xFFFFFFFF;  // Error by default
+    
+    replyPort = CreateMsgPort();
+    timerPort = CreateMsgPort();
+    if (!replyPort || !timerPort)
+    {
+        goto cleanup;
+    }
+    timerReq = (struct timerequest *)CreateIORequest(timerPort, sizeof(struct timerequest));
+    if (!timerReq || OpenDevice(TIMERNAME, UNIT_VBLANK, (struct IORequest *)timerReq, 0))
+    {
+        goto cleanup;
+    }
+    msg = (struct XMouseMsg *)AllocMem(sizeof(struct XMouseMsg), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!msg)
+    {
+        goto cleanup;
+    }
+    
+    msg->msg.mn_Node.ln_Type = NT_MESSAGE;
+    msg->msg.mn_Length = sizeof(struct XMouseMsg);
+    msg->msg.mn_ReplyPort = replyPort;
+    msg->command = cmd;
+    msg->value = value;
+    PutMsg(port, (struct Message *)msg);
+    
+    timerReq->tr_node.io_Command = TR_ADDREQUEST;
+    timerReq->tr_time.tv_secs = DAEMON_REPLY_TIMEOUT;
+    timerReq->tr_time.tv_micro = 0;
+    SendIO((struct IORequest *)timerReq);
+    
+    Wait((1L << replyPort->mp_SigBit) | (1L << timerPort->mp_SigBit));
+    
+    if (!CheckIO((struct IORequest *)timerReq))
+    {
+        AbortIO((struct IORequest *)timerReq);
+    }
+    WaitIO((struct IORequest *)timerReq);
+    
+    if (!GetMsg(replyPort))
+    {
+        // Timeout: the daemon may still reply, leave message and port to it
+        Print(MSG_ERR_DAEMON_TIMEOUT);
+        replyPort->mp_Flags = PA_IGNORE;
+        msg = NULL;
+        replyPort = NULL;
+        goto cleanup;
+    }
+    
+    result = msg->result;
+    s_replyValue = msg->value;
+
+cleanup:
+    if (msg)
+    {
+        FreeMem(msg, sizeof(struct XMouseMsg));
+    }
+    if (timerReq)
+    {
+        if (timerReq->tr_node.io_Device)
+        {
+            CloseDevice((struct IORequest *)timerReq);
+        }
+        DeleteIORequest((struct IORequest *)timerReq);
+    }
+    if (timerPort)
+    {
+        DeleteMsgPort(timerPort);
+    }
+    if (replyPort)
+    {
+        DeleteMsgPort(replyPort);
+    }
+    
+    return result;
+}
+
+/**
+ * Copy the daemon's shared block without a message round trip.
+ * The port is looked up again under Forbid() so the block can't be freed
+ * during the copy; a copy taken while the sequence is odd is retried.
+ * @param snap Destination, fully written on success
+ * @return TRUE on success, FALSE if the daemon (or a compatible block) is gone
+ */
+static BOOL readShared(struct XMouseShared *snap)
+{
+    struct XMousePort *xport;
+    ULONG seq;
+    UBYTE retry;
+    
+    for (retry = 0; retry < SHARED_READ_RETRIES; retry++)
+    {
+        Forbid();
+        xport = (struct XMousePort *)FindPort(DAEMON_PORT_NAME);
+        if (!xport || xport->magic != XMOUSE_PORT_MAGIC || !xport->shared ||
+            xport->shared->version != XMOUSE_SHARED_VERSION)
+        {
+            Permit();
+            return FALSE;
+        }
+        
+        seq = xport->shared->sequence;
+        if (!(seq & 1))
+        {
+            CopyMem((APTR)xport->shared, snap, sizeof(struct XMouseShared));
+            if (xport->shared->sequence == seq)
+            {
+                Permit();
+                return TRUE;
+            }
+        }
+        Permit();
+        
+        // Daemon preempted mid-update: let it finish
+        Delay(1);
+    }
+    return FALSE;
+}
+
+/**
+ * Parse command line arguments and determine start mode.
+ * Also parses optional config byte in hex format (0xBYTE),
+ * optionally followed by the extended options word (0xOPTIONS).
+ * @return START_MODE_* value.
+ */
+static inline BYTE parseArguments(void)
+{
+    typedef STRPTR (*GetArgStrFunc)(void);
+    GetArgStrFunc GetArgStr = (GetArgStrFunc)((UBYTE *)DOSBase + 0x114);
+    STRPTR args = GetArgStr();
+    UBYTE *p = (UBYTE *)args;
+    int hi, lo;
+    UBYTE configByte;
+    
+    // Skip leading spaces
+    while (*p == ' ' || *p == '\t')
+    {
+        p++;
+    }
+    
+    // No argument = toggle mode
+    if (*p == '\0' || *p == '\n')
+    {
+        s_configByte = DEFAULT_CONFIG_BYTE;
+        return START_MODE_TOGGLE;
+    }
+    
+    // Test STOP case-insensitive
+    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='o' && (p[3]|32)=='p')
+    {
+        return START_MODE_STOP;
+    }
+    
+    // Test START case-insensitive
+    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='a' && (p[3]|32)=='r' && (p[4]|32)=='t')
+    {
+        // Check if START is followed by nothing, space, or newline
+        if (p[5] == '\0' || p[5] == ' ' || p[5] == '\t' || p[5] == '\n')
+        {
+            // Store config byte for daemon to use
+            s_configByte = DEFAULT_CONFIG_BYTE;
+            return START_MODE_START;
+        }
+    }
+    
+    // Test STATUS case-insensitive (must come after START check)
+    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='a' && (p[3]|32)=='t' && (p[4]|32)=='u' && (p[5]|32)=='s')
+    {
+        return START_MODE_STATUS;
+    }
+    
+    // Test STATS case-insensitive (STATUS tested above)
+    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='a' && (p[3]|32)=='t' && (p[4]|32)=='s')
+    {
+        return START_MODE_STATS;
+    }
+    
+    // Test CYCLES case-insensitive
+    if ((p[0]|32)=='c' && (p[1]|32)=='y' && (p[2]|32)=='c' && (p[3]|32)=='l' && (p[4]|32)=='e' && (p[5]|32)=='s')
+    {
+        return START_MODE_CYCLES;
+    }
+    
+    // Test CIACOST case-insensitive
+    if ((p[0]|32)=='c' && (p[1]|32)=='i' && (p[2]|32)=='a' && (p[3]|32)=='c' && (p[4]|32)=='o' && (p[5]|32)=='s' && (p[6]|32)=='t')
+    {
+        return START_MODE_CIACOST;
+    }
+    
+    // Test LATENCY case-insensitive
+    if ((p[0]|32)=='l' && (p[1]|32)=='a' && (p[2]|32)=='t' && (p[3]|32)=='e' && (p[4]|32)=='n' && (p[5]|32)=='c' && (p[6]|32)=='y')
+    {
+        return START_MODE_LATENCY;
+    }
+    
+    // Test TOP case-insensitive
+    if ((p[0]|32)=='t' && (p[1]|32)=='o' && (p[2]|32)=='p' && (p[3] == '\0' || p[3] == ' ' || p[3] == '\t' || p[3] == '\n'))
+    {
+        return START_MODE_TOP;
+    }
+    
+    // Test WATCH case-insensitive
+    if ((p[0]|32)=='w' && (p[1]|32)=='a' && (p[2]|32)=='t' && (p[3]|32)=='c' && (p[4]|32)=='h')
+    {
+        return START_MODE_WATCH;
+    }
+    
+    // Test TIMING case-insensitive
+    if ((p[0]|32)=='t' && (p[1]|32)=='i' && (p[2]|32)=='m' && (p[3]|32)=='i' && (p[4]|32)=='n' && (p[5]|32)=='g')
+    {
+        return START_MODE_TIMING;
+    }
+    
+    // Test hex format: 0xBYTE
+    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+    {
+        hi = parseHexDigit(p[2]);
+        lo = parseHexDigit(p[3]);
+        
+        if (hi >= 0 && lo >= 0)
+        {
+            configByte = (UBYTE)((hi << 4) | lo);
+            
+#ifdef RELEASE
+            // Force debug bit to 0 in release builds
+            configByte &= ~CONFIG_DEBUG_MODE;
+#endif
+            
+            // Check STOP conditions: neither wheel nor buttons enabled (bits 0-1)
+            if ((configByte & CONFIG_FEATURES_MASK) == 0)
+            {
+                //PrintF("config 0x%02lx = STOP (wheel and buttons disabled)", (ULONG)configByte);
+                return START_MODE_STOP;
+            }
+            
+            // Store config byte for daemon to use
+            s_configByte = configByte;
+            
+            // Optional extended options word: 0xBYTE 0xOPTIONS
+            p += 4;
+            while (*p == ' ' || *p == '\t')
+            {
+                p++;
+            }
+            if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && parseHexDigit(p[2]) >= 0)
+            {
+                ULONG options = 0;
+                int digit, n;
+                
+                p += 2;
+                for (n = 0; n < 8 && (digit = parseHexDigit(*p)) >= 0; n++, p++)
+                {
+                    options = (options << 4) | (ULONG)digit;
+                }
+                s_options = options;
+                s_optionsSet = TRUE;
+            }
+
+            return START_MODE_CONFIG;
+        }
+    }
+    
+    // Unknown argument
+    PrintF(MSG_UNKNOWN_ARGUMENT, args);
+    return START_MODE_TOGGLE;
+}
+
+
+//===========================================================================
+// Daemon process functions
+//===========================================================================
+
+/**
+ * Execute one control command (XMouseMsg or request tag).
+ * @param msg Command and value, result (and value for GET_TIMING) set on return
+ * @param quit Set to TRUE by XMSG_CMD_QUIT
+ */
+static void daemon_Command(struct XMouseMsg *msg, BOOL *quit)
+{
+    switch (msg->command)
+    {
+        case XMSG_CMD_QUIT:
+            *quit = TRUE;
+            msg->result = 0;  // Success
+            break;
+            
+        case XMSG_CMD_SET_CONFIG:
+            {
+                UBYTE oldConfig = s_configByte;
+                UBYTE newConfig = (UBYTE)msg->value;
+                UBYTE oldInterval = (oldConfig & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT;
+                UBYTE newInterval = (newConfig & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT;
+                
+#ifdef RELEASE
+                // Force debug bit to 0 in release builds
+                newConfig &= ~CONFIG_DEBUG_MODE;
+#endif
+                
+                s_configByte = newConfig;
+                s_vblMailbox.mask = daemon_SampleMask();
+                s_ciaSampler.mask = daemon_SampleMask();
+                s_traceSampler.mask = daemon_SampleMask();
+                daemon_TickSelect();
+                msg->result = 0;  // Success
+                
+                DebugLogF("Config changed: 0x%02lx -> 0x%02lx", (ULONG)oldConfig, (ULONG)newConfig);
+                
+                // If mode changed, reinitialize adaptive system
+                if (oldInterval != newInterval || 
+                    ((oldConfig ^ newConfig) & CONFIG_USER_PROFILE) ||
+                    TICK_ENGINE(oldConfig) != TICK_ENGINE(newConfig))
+                {
+                    // Reinitialize based on new mode
+                    daemon_ApplyMode();
+                    
+                    if (newConfig & CONFIG_FIXED_MODE)
+                    {
+                        DebugLogF("Mode changed: %s (fixed %ldms)", s_activeMode->normalName, (LONG)(s_pollInterval / 1000));
+                    }
+                    else
+                    {
+                        DebugLogF("Mode changed: %s (%s)", s_activeMode->adaptiveName,
+                                  (newConfig & CONFIG_PREDICTIVE) ? ENGINE_NAME_PREDICTIVE : ENGINE_NAME_LADDER);
+                    }
+                    
+                    // Restart timer with new interval (not running with interrupt sampling)
+                    if (!SAMPLING_EVENT_DRIVEN())
+                    {
+                        AbortIO((struct IORequest *)s_TimerReq);
+                        WaitIO((struct IORequest *)s_TimerReq);
+                        daemon_TimerStart(s_pollInterval);
+                    }
+                }
+                
+#ifndef RELEASE
+                // Handle debug mode change
+                if ((oldConfig & CONFIG_DEBUG_MODE) && !(newConfig & CONFIG_DEBUG_MODE))
+                {
+                    // Debug mode disabled - logger drains and closes console
+                    daemon_LogStop();
+                }
+                else if (!(oldConfig & CONFIG_DEBUG_MODE) && (newConfig & CONFIG_DEBUG_MODE))
+                {
+                    // Debug mode enabled - start logger
+                    daemon_LogStart();
+                    DebugLog("Debug mode enabled");
+                }
+#endif
+            }
+            break;
+            
+        case XMSG_CMD_GET_STATUS:
+            // Return config byte only
+            DebugLogF("Status requested: config=0x%02lx", (ULONG)s_configByte);
+            msg->result = (ULONG)s_configByte;
+            break;
+            
+        case XMSG_CMD_SET_OPTIONS:
+            DebugLogF("Options changed: 0x%08lx -> 0x%08lx", s_options, msg->value);
+            daemon_SetOptions(msg->value);
+            msg->result = 0;  // Success
+            break;
+            
+        case XMSG_CMD_GET_OPTIONS:
+            msg->result = s_options;
+            break;
+            
+        case XMSG_CMD_GET_TIMING:
+            if (msg->value < TIMER_UNIT_COUNT)
+            {
+                TimerStats *stats = &s_timerStats[msg->value];
+                
+                msg->result = daemon_TimerAchievedUs((UBYTE)msg->value);
+                msg->value = stats->count ? stats->requestedUs / stats->count : 0;
+            }
+            else
+            {
+                msg->result = 0xFFFFFFFF;  // Error
+            }
+            break;
+            
+        case XMSG_CMD_GET_STATS:
+            {
+                struct XMouseStats *stats = (struct XMouseStats *)msg->value;
+                UWORD size;
+                
+                if (!stats || stats->size < 2 * sizeof(UWORD))
+                {
+                    msg->result = 0xFFFFFFFF;  // Error
+                    break;
+                }
+                size = (stats->size < sizeof(s_shared.stats)) ? stats->size : sizeof(s_shared.stats);
+                
+                // Header fields are kept current in the shared block
+                s_shared.stats.intervalUs = SAMPLING_EVENT_DRIVEN() ? 0 : s_pollInterval;
+                CopyMem(&s_shared.stats, stats, size);
+                stats->size = size;
+                msg->result = XMOUSE_STATS_VERSION;
+            }
+            break;
+            
+        case XMSG_CMD_GET_CYCLES:
+#ifdef CYCLE_PROFILER
+            {
+                struct XMouseCycles *cycles = (struct XMouseCycles *)msg->value;
+                UWORD size;
+                
+                if (!cycles || cycles->size < 2 * sizeof(UWORD))
+                {
+                    msg->result = 0xFFFFFFFF;  // Error
+                    break;
+                }
+                size = (cycles->size < sizeof(s_cycles)) ? cycles->size : sizeof(s_cycles);
+                
+                s_cycles.version = CYCLES_VERSION;
+                s_cycles.eclockFreq = s_eclockFreq;
+                CopyMem(&s_cycles, cycles, size);
+                cycles->size = size;
+                msg->result = CYCLES_VERSION;
+            }
+#else
+            msg->result = 0xFFFFFFFF;  // Profiler not built in
+#endif
+            break;
+            
+        case XMSG_CMD_BENCH_CIA:
+            msg->result = daemon_BenchCia((struct XMouseCiaCost *)msg->value);
+            break;
+            
+        case XMSG_CMD_SUBSCRIBE:
+            msg->result = subscribeAdd((struct XMouseSubscribe *)msg->value);
+            break;
+            
+        case XMSG_CMD_UNSUBSCRIBE:
+            msg->result = subscribeRemove((struct MsgPort *)msg->value);
+            break;
+            
+        case XMSG_CMD_BENCH_LATENCY:
+            msg->result = daemon_BenchLatency((struct XMouseLatency *)msg->value);
+            break;
+            
+        case XMSG_CMD_SET_PROFILE:
+            {
+                const struct XMouseProfile *profile = (const struct XMouseProfile *)msg->value;
+                
+                if (!profile || !daemon_ProfileSet(profile))
+                {
+                    DebugLog("Profile rejected");
+                    msg->result = 0xFFFFFFFF;  // Error
+                    break;
+                }
+                msg->result = 0;  // Success
+                
+                DebugLogF("Profile %ld: %s %ld->%ld->%ldms", (LONG)profile->slot,
+                          s_userNames[profile->slot],
+                          (LONG)(profile->idleUs / 1000),
+                          (LONG)(profile->activeUs / 1000),
+                          (LONG)(profile->burstUs / 1000));
+                
+                // Slot in use: reinitialize and restart timer (not running with interrupt sampling)
+                if (s_activeMode == &s_userModes[profile->slot])
+                {
+                    daemon_ApplyMode();
+                    
+                    if (!SAMPLING_EVENT_DRIVEN())
+                    {
+                        AbortIO((struct IORequest *)s_TimerReq);
+                        WaitIO((struct IORequest *)s_TimerReq);
+                        daemon_TimerStart(s_pollInterval);
+                    }
+                }
+            }
+            break;
+            
+        default:
+            msg->result = 0xFFFFFFFF;  // Error
+            break;
+    }
+}
+
+/**
+ * Execute a tag request (XMSG_CMD_REQUEST) in order, stopping at the
+ * first tag that fails. An abandoned request is freed unexecuted.
+ * Requests flagged XMREQ_FLAG_NOREPLY are freed instead of replied.
+ * @param req Request taken from the public port
+ * @param quit Set to TRUE by an XMSG_CMD_QUIT tag
+ */
+static void daemon_Request(struct XMouseRequest *req, BOOL *quit)
+{
+    struct XMouseMsg tagMsg;
+    UWORD i;
+    
+    // The client may give up until the daemon picks the request
+    Forbid();
+    if (req->state == XMREQ_STATE_ABANDONED)
+    {
+        Permit();
+        DebugLogF("Request %lu abandoned", req->id);
+        FreeMem(req, req->header.msg.mn_Length);
+        return;
+    }
+    req->state = XMREQ_STATE_RUNNING;
+    Permit();
+    
+    req->header.result = 0xFFFFFFFF;
+    if (req->version >= 1 && req->version <= XMREQ_VERSION &&
+        req->size >= sizeof(struct XMouseRequest) && req->count <= XMREQ_TAGS_MAX)
+    {
+        for (i = 0; i < req->count; i++)
+        {
+            tagMsg.command = (req->tags[i].tag < XMSG_CMD_REQUEST) ? (UBYTE)req->tags[i].tag : XMSG_CMD_REQUEST;
+            tagMsg.value = req->tags[i].data;
+            daemon_Command(&tagMsg, quit);
+            req->tags[i].data = tagMsg.value;
+            req->tags[i].result = tagMsg.result;
+            if (tagMsg.result == 0xFFFFFFFF)
+            {
+                break;
+            }
+            if (*quit)
+            {
+                i++;  // QUIT done, the daemon is stopping
+                break;
+            }
+        }
+        req->header.result = i;
+        
+        // Tags after a failure or a QUIT are not executed
+        for (i = req->header.result; i < req->count; i++)
+        {
+            req->tags[i].result = 0xFFFFFFFF;
+        }
+    }
+    req->version = XMREQ_VERSION;
+    
+    DebugLogF("Request %lu: %lu of %ld tag(s) done", req->id, req->header.result, (LONG)req->count);
+    
+    Forbid();
+    req->state = XMREQ_STATE_DONE;
+    if (req->flags & XMREQ_FLAG_NOREPLY)
+    {
+        FreeMem(req, req->header.msg.mn_Length);
+    }
+    else
+    {
+        ReplyMsg((struct Message *)req);
+    }
+    Permit();
+}
+
+/**
+ * Daemon main function.
+ * This function runs in a separate process.
+ */
+static void daemon(void)
+{
+    ULONG timerSig, portSig, injectSig, signals;
+    struct XMouseMsg *msg;
+    BOOL quit = FALSE;
+  
+    if (daemon_Init()) 
+    {
+#ifndef RELEASE
+        // Start logger (debug console) if debug mode enabled
+        if (s_configByte & CONFIG_DEBUG_MODE)
+        {
+            daemon_LogStart();
+            
+            DebugLog("daemon started");
+            DebugLogF("Mode: %s", getModeName(s_configByte));
+            
+            if (s_configByte & CONFIG_FIXED_MODE)
+            {
+                DebugLogF("Poll: %ldms (normal)", (LONG)(s_pollInterval / 1000));
+            }
+            else
+            {
+                DebugLogF("Poll: %ld->%ld->%ldms (%s)", 
+                          (LONG)(s_activeMode->idleUs / 1000),
+                          (LONG)(s_activeMode->activeUs / 1000),
+                          (LONG)(s_activeMode->burstUs / 1000),
+                          (s_configByte & CONFIG_PREDICTIVE) ? ENGINE_NAME_PREDICTIVE : ENGINE_NAME_LADDER);
+            }
+            
+            DebugLog("---");
+        }
+#endif        
+        // Event-driven sampling if requested, timer polling as fallback
+        daemon_SamplingApply(s_options);
+        if (!SAMPLING_EVENT_DRIVEN())
+        {
+            daemon_TimerStart(s_pollInterval);
+        }
+        
+        if (s_options & OPT_TRACE_CAPTURE)
+        {
+            daemon_TraceStart();
+        }
+        
+        if (s_options & OPT_PREWARM)
+        {
+            daemon_PrewarmStart();
+        }
+        
+        if (s_options & OPT_WHEEL_SMOOTH)
+        {
+            daemon_SmoothStart();
+        }
+        
+        if (s_options & OPT_HANDLER_INJECT)
+        {
+            injectHandlerStart();
+        }
+        
+        timerSig = 1L << s_TimerPort->mp_SigBit;
+        portSig = 1L << s_PublicPort->mp_SigBit;
+        injectSig = 1L << s_InputPort->mp_SigBit;
+        
+        for (;;)
+        {
+            // Wait for CTRL-C, timer signal, VBL samples, completed injections, or messages
+            signals = Wait(SIGBREAKF_CTRL_C | timerSig | portSig | injectSig | s_vblSignal | s_ciaSignal | s_prewarmSignal | s_subscribeSignal | s_smoothSignal);
+            s_shared.sequence++;  // Odd: block being updated
+            s_shared.stats.wakeups++;
+
+            if (signals & SIGBREAKF_CTRL_C)
+            {
+                break;
+            }
+            
+            // Completed async injections: free ring slots, send merged events
+            if (signals & injectSig)
+            {
+                injectReap();
+            }
+            
+            // Subscribers gave events back
+            if (signals & s_subscribeSignal)
+            {
+                subscribeReap();
+            }
+            
+            // Smoothing: slot of the next pending detent
+            if (signals & s_smoothSignal)
+            {
+                daemon_SmoothTick();
+            }
+            
+            // VBL interrupt latched new samples
+            if (signals & s_vblSignal)
+            {
+                daemon_VblTick();
+            }
+            
+            // CIA interrupt latched wheel movement or button changes
+            if (signals & s_ciaSignal)
+            {
+                daemon_CiaTick();
+            }
+            
+            // Process messages from public port
+            if (signals & portSig)
+            {
+                while ((msg = (struct XMouseMsg *)GetMsg(s_PublicPort)))
+                {
+                    // Tag requests are replied (or freed) by daemon_Request()
+                    if (msg->command == XMSG_CMD_REQUEST)
+                    {
+                        daemon_Request((struct XMouseRequest *)msg, &quit);
+                        continue;
+                    }
+                    
+                    daemon_Command(msg, &quit);
+                    ReplyMsg((struct Message *)msg);
+                }
+                
+                if (quit)
+                {
+                    break;
+                }
+            }
+        
+            // Timer signal: poll & inject events (stale signal ignored in VBL mode)
+            if ((signals & timerSig) && !SAMPLING_EVENT_DRIVEN())
+            {
+                // Collect the completed request before reusing it
+                GetMsg(s_TimerPort);
+                s_tickHandler();
+            }
+            
+            // Pre-warm: mouse moved while idle, then re-arm only once idle again
+            if (s_prewarmSignal)
+            {
+                if (signals & s_prewarmSignal)
+                {
+                    daemon_Prewarm();
+                }
+                s_prewarmGate.armed = (s_adaptiveState == POLL_STATE_IDLE) && 
+                                      !(s_configByte & CONFIG_FIXED_MODE) && !SAMPLING_EVENT_DRIVEN();
+            }
+            
+            // Smoothing: schedule once the tick has chosen the next poll interval
+            if (s_smoothPending && !s_smoothBusy)
+            {
+                daemon_SmoothArm();
+            }
+            
+            // Live values, then even: block consistent
+            s_shared.config = s_configByte;
+            s_shared.state = s_adaptiveState;
+            s_shared.options = s_options;
+            s_shared.stats.intervalUs = SAMPLING_EVENT_DRIVEN() ? 0 : s_pollInterval;
+            s_shared.sequence++;
+        }
+    }
+
+    daemon_Cleanup();
+}
+
+#endif // XMOUSED_HOST
+
+/**
+ * Timer tick: sample registers, inject events, schedule next tick.
+ * Hardware and OS access goes through the HAL_* macros only.
+ * Expanded once per TICK_VARIANTS row with constant flags.
+ * @param features CONFIG_WHEEL_ENABLED / CONFIG_BUTTONS_ENABLED bits
+ * @param engine CONFIG_FIXED_MODE, CONFIG_PREDICTIVE or 0 (ladders), see TICK_ENGINE()
+ */
+static inline void daemon_TickBody(UBYTE features, UBYTE engine)
+{
+    BOOL hadActivity;
+    BOOL hadWHActivity = FALSE;
+    BOOL hadBTActivity = FALSE;
+    UWORD currentBTState = s_lastBTState;
+    //BYTE currentWHDir;
+    BYTE currentWHCounter = s_lastWHCounter;
+    int currentWHDelta = 0;
+    MouseSample sample;
+#ifdef CYCLE_PROFILER
+    ULONG cycleClock;
+#endif
+
+    daemon_TimerMeasure();
+    s_shared.stats.ticks++;
+    CYCLES_START(cycleClock);
+
+    // One register read per tick: wheel and buttons from the same moment
+    if (features & (CONFIG_WHEEL_ENABLED | CONFIG_BUTTONS_ENABLED))
+    {
+        daemon_DecodeSample(HAL_ReadRegister(), &sample);
+    }
+
+    // Prepare wheel delta if WH enabled
+    if (features & CONFIG_WHEEL_ENABLED)
+    {
+        currentWHCounter = sample.wheel;
+
+        if (s_lastWHCounter != currentWHCounter)
+        {
+            // Calculate delta with wrap-around handling
+            currentWHDelta = daemon_WheelDelta(currentWHCounter);
+            hadWHActivity = TRUE;
+        }
+        else
+        {
+            hadWHActivity = s_lastWHDelta != 0;
+            currentWHDelta = 0;
+        }
+
+        // currentWHDir = (currentWHDelta == 0 ? 0 : (currentWHDelta > 0) ? 1 : -1);
+    }
+
+    // get currentButtons
+    if (features & CONFIG_BUTTONS_ENABLED) {
+        currentBTState = sample.buttons;
+        
+        // button has activity when state change or any button is pressed
+        hadBTActivity = (currentBTState != s_lastBTState) || (currentBTState != 0);
+    }
+    CYCLES_PHASE(CYCLES_PHASE_READ, cycleClock);
+
+    // Record changes of the watched register bits (stamped by the VBL
+    // sampler if installed, else at poll time)
+    if (s_trace)
+    {
+        s_traceHeader.ticks++;
+        if (s_traceSamplerOn)
+        {
+            daemon_TraceDrain();
+        }
+        else
+        {
+            daemon_TraceSample(currentBTState | (UBYTE)currentWHCounter, s_timerFireClock);
+        }
+    }
+
+    // determine if ther is an activity
+    hadActivity = hadWHActivity || hadBTActivity;
+
+    if (hadActivity) 
+    {
+        // Start a new event chain (qualifier captured once per tick)
+        // Never blocks: if the async ring is full, events are merged
+        injectBegin();
+        CYCLES_START(cycleClock);
+    
+        // Check for wheel activity
+        if (hadWHActivity)
+        {
+            daemon_ProcessWheel(currentWHDelta);
+        }
+
+        // Check for button activity
+        if (hadBTActivity)
+        {
+            daemon_ProcessButtons(currentBTState);
+        }
+
+        // Submit the whole chain in one request
+        injectFlush();
+        CYCLES_PHASE(CYCLES_PHASE_INJECT, cycleClock);
+
+#ifndef RELEASE
+        if (s_tickSubmits > s_maxTickSubmits)
+        {
+            s_maxTickSubmits = s_tickSubmits;
+        }
+        if (s_tickSubmits)
+        {
+            DebugLogF("Inject: %ld submit(s) this tick (max %ld)", 
+                      (LONG)s_tickSubmits, (LONG)s_maxTickSubmits);
+        }
+#endif
+    }
+
+    // Update adaptive interval and schedule next tick
+    CYCLES_START(cycleClock);
+    if (engine == CONFIG_FIXED_MODE)
+    {
+        // Fixed mode: constant interval, direct restart
+        daemon_TimerNext(s_pollInterval);
+    }
+    else if (engine == CONFIG_PREDICTIVE)
+    {
+        // Predictive mode: interval from the expected next event
+        daemon_StatsState(s_pollInterval);
+        s_pollInterval = daemon_GetPredictiveInterval(hadActivity);
+        daemon_TimerNext(s_pollInterval);
+    }
+    else
+    {
+        // Adaptive mode: update interval and restart
+        // No need for AbortIO/WaitIO here - timer already completed (we got the signal)
+        daemon_StatsState(s_pollInterval);
+        s_pollInterval = daemon_GetAdaptiveInterval(hadActivity);
+        daemon_TimerNext(s_pollInterval);
+    }
+    CYCLES_PHASE(CYCLES_PHASE_ADAPT, cycleClock);
+    
+#ifndef RELEASE
+    if (s_configByte & CONFIG_DEBUG_MODE)
+    {
+        s_pollCount++;
+        
+        // Log every 1000 timer polls (e.g., every 10 seconds at 10ms interval)
+        //if (s_pollCount % 1000 == 0)
+        //{
+        //    DebugLogF("Timer polls: %lu (interval: %ldms)", s_pollCount, (LONG)(s_pollInterval / 1000));
+        //}
+    }
+#endif
+
+    // Update last values
+    s_lastWHCounter = currentWHCounter;
+    s_lastWHDelta   = currentWHDelta;
+    //s_lastWHDir     = currentWHDir;
+    s_lastBTState   = currentBTState;
+    
+    daemon_StatsTick(s_timerFireClock);
+}
+
+// Tick handlers, one per TICK_VARIANTS row
+#define TICK_HANDLER(name, features, engine) \
+    static void daemon_Tick##name(void) { daemon_TickBody(features, engine); }
+TICK_VARIANTS(TICK_HANDLER)
+
+#define TICK_ENTRY(name, features, engine) daemon_Tick##name,
+static const TickHandler s_tickHandlers[TICK_VARIANT_COUNT] = { TICK_VARIANTS(TICK_ENTRY) };
+
+/**
+ * Select the tick handler matching the current config byte.
+ * Called whenever s_configByte changes (init and SET_CONFIG).
+ */
+static inline void daemon_TickSelect(void)
+{
+    s_tickHandler = s_tickHandlers[TICK_INDEX(s_configByte)];
+}
+
+/**
+ * Start the timer with the specified timeout in microseconds.
+ * Counts from now: used at start and after an abort (WAITECLOCK resyncs
+ * its deadline grid here).
+ * @param micros Timeout in microseconds.
+ */
+static inline void daemon_TimerStart(ULONG micros)
+{
+    struct EClockVal clock;
+    
+    HAL_ReadClock(&clock);
+    s_timerStartClock = clock.ev_lo;
+    s_timerRequested = micros;
+    
+    s_TimerReq->tr_node.io_Command = TR_ADDREQUEST;
+    switch (s_timerUnit)
+    {
+        case TIMER_UNIT_WAITECLOCK:
+            // Absolute deadline: now + interval
+            s_timerDeadline = clock;
+            s_timerDeadline.ev_lo += daemon_TimerTicks(micros);
+            if (s_timerDeadline.ev_lo < clock.ev_lo)
+            {
+                s_timerDeadline.ev_hi++;
+            }
+            s_TimerReq->tr_time.tv_secs = s_timerDeadline.ev_hi;
+            s_TimerReq->tr_time.tv_micro = s_timerDeadline.ev_lo;
+            break;
+            
+        case TIMER_UNIT_ECLOCK:
+            // EClockVal in tr_time: ticks fit 32 bits for intervals up to 1s
+            s_TimerReq->tr_time.tv_secs = 0;
+            s_TimerReq->tr_time.tv_micro = daemon_TimerTicks(micros);
+            break;
+            
+        default:
+            // Poll intervals are below 1s: no per-tick division
+            if (micros < 1000000)
+            {
+                s_TimerReq->tr_time.tv_secs = 0;
+                s_TimerReq->tr_time.tv_micro = micros;
+            }
+            else
+            {
+                s_TimerReq->tr_time.tv_secs = micros / 1000000;
+                s_TimerReq->tr_time.tv_micro = micros % 1000000;
+            }
+            break;
+    }
+    
+    HAL_TimerSend(s_TimerReq);
+}
+
+/**
+ * Schedule the next tick after the one just processed.
+ * WAITECLOCK advances the previous deadline by the interval: a deadline
+ * already passed fires at once (catch up), deadlines missed entirely are
+ * skipped to stay on the grid. Relative units start from now.
+ * @param micros Interval in microseconds.
+ */
+static inline void daemon_TimerNext(ULONG micros)
+{
+    struct EClockVal now;
+    ULONG ticks;
+    UBYTE skipped = 0;
+    
+    if (s_timerUnit != TIMER_UNIT_WAITECLOCK)
+    {
+        daemon_TimerStart(micros);
+        
+        // Period measured from the completed tick, processing time included
+        s_timerStartClock = s_timerFireClock;
+        return;
+    }
+    
+    ticks = daemon_TimerTicks(micros);
+    s_timerStartClock = s_timerDeadline.ev_lo;
+    s_timerRequested = micros;
+    
+    s_timerDeadline.ev_lo += ticks;
+    if (s_timerDeadline.ev_lo < ticks)
+    {
+        s_timerDeadline.ev_hi++;
+    }
+    
+    // Skip while even the following deadline is already in the past
+    HAL_ReadClock(&now);
+    while (daemon_ClockSince(&s_timerDeadline, &now) >= ticks)
+    {
+        if (++skipped > TIMER_MAX_SKIP)
+        {
+            // Too far behind: restart the grid from now
+            s_timerDeadline = now;
+            break;
+        }
+        s_timerDeadline.ev_lo += ticks;
+        if (s_timerDeadline.ev_lo < ticks)
+        {
+            s_timerDeadline.ev_hi++;
+        }
+        s_timerSkipped++;
+    }
+    
+    if (skipped)
+    {
+        DebugLogF("Timer: %ld deadline(s) skipped (total %ld)", (LONG)skipped, (LONG)s_timerSkipped);
+    }
+    
+    s_TimerReq->tr_node.io_Command = TR_ADDREQUEST;
+    s_TimerReq->tr_time.tv_secs = s_timerDeadline.ev_hi;
+    s_TimerReq->tr_time.tv_micro = s_timerDeadline.ev_lo;
+    HAL_TimerSend(s_TimerReq);
+}
+
+/**
+ * EClock ticks elapsed between two 64-bit EClock values.
+ * @param from Start time
+ * @param to End time
+ * @return Ticks (saturated to 32 bits), 0 if to is not after from
+ */
+static inline ULONG daemon_ClockSince(const struct EClockVal *from, const struct EClockVal *to)
+{
+    if (to->ev_hi < from->ev_hi || (to->ev_hi == from->ev_hi && to->ev_lo <= from->ev_lo))
+    {
+        return 0;
+    }
+    if (to->ev_hi - from->ev_hi > 1 || (to->ev_hi != from->ev_hi && to->ev_lo >= from->ev_lo))
+    {
+        return 0xFFFFFFFF;
+    }
+    return to->ev_lo - from->ev_lo;
+}
+
+/**
+ * Convert an interval to EClock ticks.
+ * Multiply and shift only, recomputed when the interval changes.
+ * @param micros Interval in microseconds (up to 1s)
+ * @return Interval in EClock ticks
+ */
+static inline ULONG daemon_TimerTicks(ULONG micros)
+{
+    if (micros != s_timerTicksUs)
+    {
+        s_timerTicksUs = micros;
+        s_timerTicks = (micros * s_eclockPerUsQ12) >> 12;
+    }
+    return s_timerTicks;
+}
+
+#ifndef XMOUSED_HOST
+/**
+ * Open timer.device on the given unit.
+ * Falls back to UNIT_VBLANK if the unit cannot be opened.
+ * Timer request must not be pending and device must be closed.
+ * @param unit TIMER_UNIT_* value
+ * @return TRUE on success, FALSE if no unit could be opened
+ */
+static BOOL daemon_TimerOpen(UBYTE unit)
+{
+    struct EClockVal clock;
+    
+    if (unit >= TIMER_UNIT_COUNT || 
+        OpenDevice(TIMERNAME, s_timerDeviceUnits[unit], (struct IORequest *)s_TimerReq, 0))
+    {
+        unit = TIMER_UNIT_VBLANK;
+        if (OpenDevice(TIMERNAME, UNIT_VBLANK, (struct IORequest *)s_TimerReq, 0))
+        {
+            s_TimerReq->tr_node.io_Device = NULL;
+            return FALSE;
+        }
+    }
+    s_timerUnit = unit;
+    
+    // Get TimerBase for ReadEClock inline pragma
+    TimerBase = s_TimerReq->tr_node.io_Device;
+    daemon_ClockInit(HAL_ReadClock(&clock));
+    
+    DebugLogF("Timer: %s", s_timerUnitNames[unit]);
+    return TRUE;
+}
+
+#endif // XMOUSED_HOST
+
+/**
+ * Compute EClock conversion factors (only divisions, done once).
+ * @param freq EClock frequency (Hz)
+ */
+static inline void daemon_ClockInit(ULONG freq)
+{
+    s_shared.stats.eclockFreq = freq;
+    s_eclockFreq = freq;
+    s_eclockPerUsQ12 = (freq << 8) / 62500;  // (freq << 12) / 1000000 without overflow above 1MHz
+    s_timerTicksUs = 0xFFFFFFFF;  // Force reconversion
+    s_accelWindow = freq / ACCEL_WINDOW_DIV;
+    s_accelSliceTicks = s_accelWindow / ACCEL_SLICES;
+}
+
+/**
+ * Account the interval of the request that just completed.
+ * Sums are halved every TIMER_STATS_MAX ticks (sliding mean, no overflow).
+ */
+static inline void daemon_TimerMeasure(void)
+{
+    struct EClockVal clock;
+    TimerStats *stats = &s_timerStats[s_timerUnit];
+    
+    HAL_ReadClock(&clock);
+    s_timerFireClock = clock.ev_lo;
+    
+    stats->count++;
+    stats->requestedUs += s_timerRequested;
+    stats->elapsedClock += clock.ev_lo - s_timerStartClock;
+    
+    if (stats->count >= TIMER_STATS_MAX)
+    {
+        stats->count >>= 1;
+        stats->requestedUs >>= 1;
+        stats->elapsedClock >>= 1;
+    }
+    
+#ifndef RELEASE
+    if ((s_configByte & CONFIG_DEBUG_MODE) && (stats->count % TIMER_REPORT_TICKS) == 0)
+    {
+        DebugLogF("Timer %s: requested %ldus, achieved %ldus", 
+                  s_timerUnitNames[s_timerUnit],
+                  (LONG)(stats->requestedUs / stats->count),
+                  (LONG)daemon_TimerAchievedUs(s_timerUnit));
+    }
+#endif
+}
+
+/**
+ * Mean achieved interval for a timer unit.
+ * @param unit TIMER_UNIT_* value
+ * @return Microseconds, 0 if no samples
+ */
+static inline ULONG daemon_TimerAchievedUs(UBYTE unit)
+{
+    TimerStats *stats = &s_timerStats[unit];
+    
+    if (stats->count == 0 || s_eclockFreq < 1000) return 0;
+    
+    return (stats->elapsedClock / stats->count) * 1000 / (s_eclockFreq / 1000);
+}
+
+/**
+ * Start a new event chain for the current tick.
+ * Captures the qualifier once, shared by all events of the chain,
+ * then requeues events merged while the async ring was full.
+ */
+static inline void injectBegin(void)
+{
+#ifdef CYCLE_PROFILER
+    ULONG cycleClock;
+#endif
+    
+    s_injectSlot = NULL;
+    s_tickSubmits = 0;
+    CYCLES_START(cycleClock);
+    s_eventQualifier = HAL_PeekQualifier();
+    CYCLES_PHASE(CYCLES_PHASE_QUALIFIER, cycleClock);
+    
+    // Pending wheel detents first (merged into a single delta)
+    if (s_pendingWheel)
+    {
+        int delta = s_pendingWheel;
+        
+        s_pendingWheel = 0;
+        injectWheel(delta);
+    }
+    
+    // Then pending button codes, in order
+    if (s_pendingButtonCount)
+    {
+        UBYTE i, n = 0;
+        
+        while (n < s_pendingButtonCount && injectReserve(2))
+        {
+            injectQueue(IECLASS_RAWKEY, s_pendingButtons[n]);
+            injectQueue(IECLASS_NEWMOUSE, s_pendingButtons[n]);
+            n++;
+        }
+        for (i = n; i < s_pendingButtonCount; i++)
+        {
+            s_pendingButtons[i - n] = s_pendingButtons[i];
+        }
+        s_pendingButtonCount -= n;
+    }
+}
+
+/**
+ * Make room for events in the current chain.
+ * Submits a full chain and takes the next slot: slot 0 in sync mode
+ * (always free after DoIO), next idle ring slot in async mode.
+ * @param count Number of events to add
+ * @return TRUE if room is available, FALSE if the async ring is full
+ */
+static inline BOOL injectReserve(UWORD count)
+{
+    UBYTE i;
+    
+    if (s_injectSlot)
+    {
+        if (s_injectSlot->count + count <= INJECT_POOL_SIZE)
+        {
+            return TRUE;
+        }
+        injectFlush();
+    }
+    
+    if (!(s_options & (OPT_ASYNC_INJECT | OPT_HANDLER_INJECT)))
+    {
+        s_injectSlot = &s_injectRing[0];
+        return TRUE;
+    }
+    
+#ifndef XMOUSED_HOST
+    injectHandlerRelease();
+#endif
+    
+    for (i = 0; i < INJECT_RING_SIZE; i++)
+    {
+        InjectSlot *slot = &s_injectRing[s_injectNext];
+        
+        s_injectNext = (s_injectNext + 1) % INJECT_RING_SIZE;
+        if (!slot->busy)
+        {
+            s_injectSlot = slot;
+            return TRUE;
+        }
+    }
+    
+    return FALSE;
+}
+
+/**
+ * Append an event to the current chain.
+ * Caller must have reserved room with injectReserve().
+ * @param ieClass Event class (IECLASS_RAWKEY or IECLASS_NEWMOUSE)
+ * @param code Event code (NM_WHEEL_*, NM_BUTTON_* with optional IECODE_UP_PREFIX)
+ * @return Queued event, for callers adding a payload
+ */
+static inline struct InputEvent *injectQueue(UBYTE ieClass, UWORD code)
+{
+    InjectSlot *slot = s_injectSlot;
+    struct InputEvent *ev = &slot->events[slot->count];
+    
+    // Handlers may modify events in place, so every field is rewritten
+    ev->ie_NextEvent = NULL;
+    ev->ie_Class = ieClass;
+    ev->ie_SubClass = 0;
+    ev->ie_Code = code;
+    ev->ie_Qualifier = s_eventQualifier;
+    ev->ie_X = 0;
+    ev->ie_Y = 0;
+    ev->ie_TimeStamp.tv_secs = 0;
+    ev->ie_TimeStamp.tv_micro = 0;
+    
+    if (slot->count)
+    {
+        slot->events[slot->count - 1].ie_NextEvent = ev;
+    }
+    slot->count++;
+    
+    return ev;
+}
+
+/**
+ * Queue RAWKEY + NEWMOUSE pairs for a wheel delta.
+ * Coalesced mode queues a single pair for the whole delta, the detent
+ * count in the NEWMOUSE event's ie_Y (opt-in extension: standard
+ * consumers see one detent).
+ * Detents that find no free slot are merged into s_pendingWheel.
+ * @param delta Signed wheel delta (positive = UP)
+ */
+static inline void injectWheel(int delta)
+{
+    UWORD code = (delta > 0) ? NM_WHEEL_UP : NM_WHEEL_DOWN;
+    int count = ((delta > 0) ? delta : -delta);
+    
+    if (s_options & OPT_WHEEL_COALESCE)
+    {
+        if (!injectReserve(2))
+        {
+            s_pendingWheel += delta;
+            return;
+        }
+        
+        // Same pair as one detent, magnitude in ie_Y for aware consumers
+        injectQueue(IECLASS_RAWKEY, code);
+        injectQueue(IECLASS_NEWMOUSE, code)->ie_Y = (WORD)count;
+        s_shared.stats.events[STATS_CLASS_WHEEL] += 2;
+        return;
+    }
+    
+    while (count)
+    {
+        if (!injectReserve(2))
+        {
+            // Ring full: merge remaining detents, sent when a request completes
+            s_pendingWheel += (delta > 0) ? count : -count;
+            return;
+        }
+        
+        // Queue both RAWKEY - Modern apps
+        injectQueue(IECLASS_RAWKEY, code);
+        
+        // and NEWMOUSE - Legacy apps
+        injectQueue(IECLASS_NEWMOUSE, code);
+        s_shared.stats.events[STATS_CLASS_WHEEL] += 2;
+        count--;
+    }
+}
+
+/**
+ * Queue RAWKEY + NEWMOUSE pair for a button edge.
+ * Codes that find no free slot are held in order until one completes.
+ * @param code NM_BUTTON_* code with optional IECODE_UP_PREFIX
+ */
+static inline void injectButton(UWORD code)
+{
+    if (!injectReserve(2))
+    {
+        if (s_pendingButtonCount < INJECT_PENDING_MAX)
+        {
+            s_pendingButtons[s_pendingButtonCount++] = code;
+        }
+#ifndef RELEASE
+        else
+        {
+            s_droppedButtons++;
+        }
+#endif
+        return;
+    }
+    
+    injectQueue(IECLASS_RAWKEY, code);
+    injectQueue(IECLASS_NEWMOUSE, code);
+    s_shared.stats.events[STATS_CLASS_BUTTONS] += 2;
+}
+
+/**
+ * Submit the current chain to input.device in a single request.
+ * Sync mode waits with DoIO, async mode returns at once with SendIO
+ * and the slot is released by injectReap(). Handler mode queues the
+ * chain for injectHandler() instead (released once spliced).
+ */
+static inline void injectFlush(void)
+{
+    InjectSlot *slot = s_injectSlot;
+    
+    if (!slot || slot->count == 0) return;
+    
+#ifndef XMOUSED_HOST
+    if (s_handlerReq && (s_options & OPT_HANDLER_INJECT))
+    {
+        HandlerQueue *q = &s_handlerQueue;
+        UBYTE head = q->head;
+        
+        if (s_trace)
+        {
+            struct EClockVal now;
+            
+            HAL_ReadClock(&now);
+            daemon_TraceRecord(TRACE_INJECT, slot->count, now.ev_lo);
+        }
+        
+        // Queue never full: each entry holds a busy slot, HANDLER_QUEUE_SIZE > INJECT_RING_SIZE
+        slot->busy = TRUE;
+        s_handlerSlots[head] = slot;
+        q->first[head] = &slot->events[0];
+        q->last[head] = &slot->events[slot->count - 1];
+        q->head = (head + 1) & (HANDLER_QUEUE_SIZE - 1);
+        s_injectSlot = NULL;
+        
+        if (!s_kickBusy)
+        {
+            injectKick();
+        }
+        
+        slot->count = 0;
+        s_tickSubmits++;
+        s_shared.stats.submits++;
+        return;
+    }
+#endif
+    
+    slot->req->io_Command = IND_WRITEEVENT;
+    slot->req->io_Data = (APTR)slot->events;
+    slot->req->io_Length = sizeof(struct InputEvent);
+    
+    if (s_trace)
+    {
+        struct EClockVal now;
+        
+        HAL_ReadClock(&now);
+        daemon_TraceRecord(TRACE_INJECT, slot->count, now.ev_lo);
+    }
+    
+    if (s_options & OPT_ASYNC_INJECT)
+    {
+        slot->busy = TRUE;
+        HAL_InjectAsync(slot->req);
+        s_injectSlot = NULL;
+    }
+    else
+    {
+        HAL_InjectSync(slot->req);
+    }
+    
+    slot->count = 0;
+    s_tickSubmits++;
+    s_shared.stats.submits++;
+}
+
+/**
+ * Collect completed async requests and release their slots.
+ * Events merged while the ring was full are sent right away.
+ */
+static inline void injectReap(void)
+{
+    struct IORequest *io;
+    UBYTE i;
+    
+    while ((io = HAL_InjectReaped(s_InputPort)))
+    {
+#ifndef XMOUSED_HOST
+        if (io == (struct IORequest *)s_kickReq)
+        {
+            s_kickBusy = FALSE;
+            continue;
+        }
+#endif
+        for (i = 0; i < INJECT_RING_SIZE; i++)
+        {
+            if ((struct IORequest *)s_injectRing[i].req == io)
+            {
+                s_injectRing[i].busy = FALSE;
+                break;
+            }
+        }
+    }
+    
+#ifndef XMOUSED_HOST
+    // Release chains covered by the kick reply, kick again for those queued after it
+    if (s_handlerReq)
+    {
+        injectHandlerRelease();
+        if (s_handlerReleased != s_handlerQueue.head && !s_kickBusy)
+        {
+            injectKick();
+        }
+    }
+#endif
+    
+    if (s_pendingWheel || s_pendingButtonCount)
+    {
+        injectBegin();
+        injectFlush();
+    }
+}
+
+/**
+ * Wait for all async requests in flight (mode change, shutdown).
+ */
+static inline void injectDrain(void)
+{
+    UBYTE i;
+    
+#ifndef XMOUSED_HOST
+    // Handler mode: kick until every queued chain is released
+    while (s_kickBusy || (s_handlerReq && s_handlerReleased != s_handlerQueue.head))
+    {
+        if (!s_kickBusy)
+        {
+            injectKick();
+        }
+        HAL_InjectWait(s_kickReq);
+        s_kickBusy = FALSE;
+        injectHandlerRelease();
+    }
+#endif
+    
+    for (i = 0; i < INJECT_RING_SIZE; i++)
+    {
+        if (s_injectRing[i].busy)
+        {
+            HAL_InjectWait(s_injectRing[i].req);
+            s_injectRing[i].busy = FALSE;
+        }
+    }
+}
+
+/**
+ * Decode a register snapshot (HAL_ReadRegister) into axes and buttons.
+ * @param raw Register word: buttons in bits 8-9, wheel counter in bits 0-7
+ * @param sample Decoded sample
+ */
+static inline void daemon_DecodeSample(UWORD raw, MouseSample *sample)
+{
+    sample->wheel = (BYTE)(raw & SAGA_WHEEL_MASK);
+    sample->hwheel = 0;
+    sample->buttons = raw & SAGA_BUTTONS_MASK;
+}
+
+/**
+ * Compute wheel delta from last counter with wrap-around handling.
+ * @param counter Current wheel counter
+ * @return Signed delta (-128..127)
+ */
+static inline int daemon_WheelDelta(BYTE counter)
+{
+    int delta = (int)(unsigned char)counter - (int)(unsigned char)s_lastWHCounter;
+    
+    if (delta > 127)
+    {
+        delta -= 256;
+    }
+    else if (delta < -128)
+    {
+        delta += 256;
+    }
+    return delta;
+}
+
+/**
+ * Scale a wheel delta by the active profile's acceleration curve.
+ * Speed is the number of detents seen in the last 100ms (EClock slices),
+ * the gain is read from s_accelCurves. Fractions are carried over so slow
+ * scrolling is never rounded away. No division, no FPU.
+ * @param delta Raw wheel delta
+ * @return Accelerated delta (same sign, |result| >= |delta|)
+ */
+static inline int daemon_AccelerateWheel(int delta)
+{
+    struct EClockVal clock;
+    ULONG now, elapsed, speed, scaled;
+    int count;
+    UBYTE i;
+    
+    if (delta == 0) return 0;
+    
+    count = (delta > 0) ? delta : -delta;
+    HAL_ReadClock(&clock);
+    now = clock.ev_lo;
+    
+    // Direction change or idle for a whole window restarts the estimate
+    elapsed = now - s_accelSliceStart;
+    if ((delta > 0) != (s_accelDir > 0) || elapsed >= s_accelWindow)
+    {
+        for (i = 0; i < ACCEL_SLICES; i++)
+        {
+            s_accelSlices[i] = 0;
+        }
+        s_accelSum = 0;
+        s_accelFrac = 0;
+        s_accelSliceStart = now;
+        s_accelDir = (delta > 0) ? 1 : -1;
+    }
+    else
+    {
+        // Move to the current slice, forgetting the ones leaving the window
+        while (elapsed >= s_accelSliceTicks)
+        {
+            s_accelSlice = (s_accelSlice + 1) & (ACCEL_SLICES - 1);
+            s_accelSum -= s_accelSlices[s_accelSlice];
+            s_accelSlices[s_accelSlice] = 0;
+            s_accelSliceStart += s_accelSliceTicks;
+            elapsed -= s_accelSliceTicks;
+        }
+        if (s_accelSum == 0)
+        {
+            s_accelFrac = 0;  // Old spin fully expired
+        }
+    }
+    
+    if (count > 255 - s_accelSlices[s_accelSlice])
+    {
+        s_accelSum += 255 - s_accelSlices[s_accelSlice];
+        s_accelSlices[s_accelSlice] = 255;
+    }
+    else
+    {
+        s_accelSum += (UWORD)count;
+        s_accelSlices[s_accelSlice] += (UBYTE)count;
+    }
+    
+    speed = s_accelSum;
+    if (speed >= ACCEL_SPEED_STEPS)
+    {
+        speed = ACCEL_SPEED_STEPS - 1;
+    }
+    
+    scaled = (ULONG)count * s_accelCurves[s_activeMode->accelCurve][speed] + s_accelFrac;
+    s_accelFrac = (UWORD)(scaled & 0xFF);
+    count = (int)(scaled >> 8);
+    if (count > 127)
+    {
+        count = 127;
+    }
+    
+    DebugLogF("Accel: %ld -> %ld (speed %ld)", (LONG)delta, (LONG)((delta > 0) ? count : -count), (LONG)speed);
+    
+    return (delta > 0) ? count : -count;
+}
+
+/**
+ * Process wheel movement and queue events if needed.
+ * @param delta Current wheel delta
+ */
+static inline void daemon_ProcessWheel(int delta)
+{
+    ULONG detents;
+    
+    if (delta == 0) return;
+    
+    detents = (ULONG)((delta > 0) ? delta : -delta);
+    if (detents > s_shared.stats.maxWheelDelta)
+    {
+        s_shared.stats.maxWheelDelta = detents;
+    }
+    
+    if (s_options & OPT_WHEEL_ACCEL)
+    {
+        delta = daemon_AccelerateWheel(delta);
+    }
+    
+    DebugLogF("Wheel: %s delta=%ld", (delta > 0) ? "UP" : "DOWN", (LONG)delta);
+    
+    if (SUBSCRIBE_POST((delta > 0) ? NM_WHEEL_UP : NM_WHEEL_DOWN, (WORD)delta))
+    {
+        return;
+    }
+    
+    if (SMOOTH_WHEEL(delta))
+    {
+        return;
+    }
+    
+    // Repeat events based on delta
+    injectWheel(delta);
+}
+
+/**
+ * Process buttons and queue events if needed.
+ * @param state Current button state (MouseSample.buttons)
+ */
+static inline void daemon_ProcessButtons(UWORD state)
+{
+    UWORD changed;
+    UWORD code;
+    
+    // Use provided current value (already read and masked in main loop)
+    changed = state ^ s_lastBTState;
+    
+    if (changed)
+    {
+        if (changed & SAGA_BUTTON4_MASK)
+        {
+            code = NM_BUTTON_FOURTH | ((state & SAGA_BUTTON4_MASK) ? 0 : IECODE_UP_PREFIX);
+        
+            DebugLogF("Button 4: %s", (state & SAGA_BUTTON4_MASK) ? "PRESS" : "RELEASE");
+
+            if (!SUBSCRIBE_POST(code, 0))
+            {
+                injectButton(code);
+            }
+        }
+        
+        if (changed & SAGA_BUTTON5_MASK)
+        {
+            code = NM_BUTTON_FIFTH | ((state & SAGA_BUTTON5_MASK) ? 0 : IECODE_UP_PREFIX);
+
+            DebugLogF("Button 5: %s", (state & SAGA_BUTTON5_MASK) ? "PRESS" : "RELEASE");
+
+            if (!SUBSCRIBE_POST(code, 0))
+            {
+                injectButton(code);
+            }
+        }
+    }
+}
+
+/**
+ * Update adaptive polling interval based on activity.
+ * State machine: IDLE → ACTIVE → BURST → TO_IDLE → IDLE
+ * Walks the precomputed ladders (see daemon_LadderBuild()): one index
+ * step per tick, the selected entry primes the EClock conversion cache.
+ * Entering ACTIVE or TO_IDLE continues from the current interval.
+ * Only called in adaptive mode (bit 6 = 0). Normal mode bypasses this function.
+ * @param hadActivity TRUE if wheel/button activity detected this tick
+ */
+static inline ULONG daemon_GetAdaptiveInterval(BOOL hadActivity)
+{
+    const AdaptiveMode *mode = s_activeMode;
+    const AdaptiveStep *entry;
+#ifndef RELEASE
+    UBYTE oldState = s_adaptiveState;
+#endif
+    UBYTE step = s_adaptiveStep;
+    ULONG from;
+    
+    if (hadActivity)
+    {
+        s_adaptiveInactive = 0;  // Reset accumulated inactive time
+        
+        switch (s_adaptiveState)
+        {
+            case POLL_STATE_IDLE:
+                // Jump to ACTIVE (top of descent)
+                s_adaptiveState = POLL_STATE_ACTIVE;
+                if (s_ladderDec[0].us != mode->activeUs)
+                {
+                    daemon_LadderFill(s_ladderDec, &s_ladderDecLast, mode->activeUs, mode->burstUs, mode->stepDecUs);
+                }
+                step = 0;
+                break;
+                
+            case POLL_STATE_ACTIVE:
+                // Descend toward BURST every tick with activity
+                if (++step >= s_ladderDecLast)
+                {
+                    s_adaptiveState = POLL_STATE_BURST;
+                    step = s_ladderDecLast;
+                }
+                break;
+                
+            case POLL_STATE_TO_IDLE:
+                // Return to ACTIVE from the current interval, not above activeUs
+                s_adaptiveState = POLL_STATE_ACTIVE;
+                from = (s_adaptiveInterval > mode->activeUs) ? mode->activeUs : s_adaptiveInterval;
+                if (s_ladderDec[0].us != from)
+                {
+                    daemon_LadderFill(s_ladderDec, &s_ladderDecLast, from, mode->burstUs, mode->stepDecUs);
+                }
+                step = 0;
+                break;
+        }
+    }
+    else
+    {
+        s_adaptiveInactive += s_adaptiveInterval;  // Add current interval to inactive time
+        
+        if (s_adaptiveState == POLL_STATE_TO_IDLE)
+        {
+            // Ascend toward IDLE every tick without activity
+            if (++step >= s_ladderIncLast)
+            {
+                s_adaptiveState = POLL_STATE_IDLE;
+                step = s_ladderIncLast;
+            }
+        }
+        else if (s_adaptiveState != POLL_STATE_IDLE &&
+                 s_adaptiveInactive >= s_adaptiveThreshold[s_adaptiveState])
+        {
+            // ACTIVE/BURST grace period over: ascend from the current interval
+            s_adaptiveState = POLL_STATE_TO_IDLE;
+            if (s_ladderInc[0].us != s_adaptiveInterval)
+            {
+                daemon_LadderFill(s_ladderInc, &s_ladderIncLast, s_adaptiveInterval, mode->idleUs, mode->stepIncUs);
+            }
+            step = 0;
+        }
+    }
+    
+    s_adaptiveStep = step;
+    entry = (s_adaptiveState == POLL_STATE_ACTIVE || s_adaptiveState == POLL_STATE_BURST) ?
+            &s_ladderDec[step] : &s_ladderInc[step];
+    s_adaptiveInterval = entry->us;
+    
+    // Ready-made EClock ticks for daemon_TimerTicks()
+    s_timerTicksUs = entry->us;
+    s_timerTicks = entry->ticks;
+
+#ifndef RELEASE
+    // Log state changes (even without interval change)
+    if (s_configByte & CONFIG_DEBUG_MODE)
+    {
+        // State changed?
+        if (oldState != s_adaptiveState)
+        {
+            DebugLogF("Adaptive: [%s->%s] interval=%ldus | InactiveUs=%ld", 
+                      s_pollStateNames[oldState], s_pollStateNames[s_adaptiveState], 
+                      (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
+        }
+    }
+#endif
+
+    return s_adaptiveInterval;
+}
+
+/**
+ * Update predictive polling interval based on activity.
+ * Tracks the mean time between active ticks (EWMA) and its deviation,
+ * schedules the next tick just before the predicted event, polls the
+ * expected window at deviation / 2 and backs off after a miss.
+ * States are reported as in adaptive mode: IDLE at idleUs, BURST at
+ * burstUs, ACTIVE while an event is expected, TO_IDLE while backing off.
+ * Only called with config bit 2 set in adaptive mode.
+ * @param hadActivity TRUE if wheel/button activity detected this tick
+ */
+static inline ULONG daemon_GetPredictiveInterval(BOOL hadActivity)
+{
+    const AdaptiveMode *mode = s_activeMode;
+#ifndef RELEASE
+    UBYTE oldState = s_adaptiveState;
+#endif
+    ULONG us;
+    
+    s_predictElapsed += s_adaptiveInterval;
+    
+    if (hadActivity)
+    {
+        if (s_adaptiveState == POLL_STATE_IDLE)
+        {
+            // First event after rest: no history, assume activeUs
+            s_predictGap = mode->activeUs;
+            s_predictDev = mode->activeUs >> 1;
+        }
+        else
+        {
+            // Event arrived during the last interval: sample its middle
+            ULONG sample = s_predictElapsed - (s_adaptiveInterval >> 1);
+            ULONG error;
+            
+            if (sample >= s_predictGap)
+            {
+                error = sample - s_predictGap;
+                s_predictGap += error >> PREDICT_GAP_SHIFT;
+            }
+            else
+            {
+                error = s_predictGap - sample;
+                s_predictGap -= error >> PREDICT_GAP_SHIFT;
+            }
+            
+            if (error >= s_predictDev)
+            {
+                s_predictDev += (error - s_predictDev) >> PREDICT_DEV_SHIFT;
+            }
+            else
+            {
+                s_predictDev -= (s_predictDev - error) >> PREDICT_DEV_SHIFT;
+            }
+        }
+        
+        s_predictElapsed = 0;
+        s_adaptiveInactive = 0;
+        
+        // Wake just before the predicted arrival
+        us = (s_predictGap > s_predictDev) ? s_predictGap - s_predictDev : 0;
+        s_adaptiveState = POLL_STATE_ACTIVE;
+    }
+    else if (s_adaptiveState == POLL_STATE_IDLE)
+    {
+        us = mode->idleUs;
+    }
+    else
+    {
+        s_adaptiveInactive = s_predictElapsed;
+        
+        if (s_predictElapsed < s_predictGap + (s_predictDev << PREDICT_WINDOW_SHIFT))
+        {
+            // Event expected now: poll the window finely
+            us = s_predictDev >> 1;
+            s_adaptiveState = POLL_STATE_ACTIVE;
+        }
+        else
+        {
+            // Prediction missed: back off with the silence
+            us = s_predictElapsed >> PREDICT_BACKOFF_SHIFT;
+            s_adaptiveState = POLL_STATE_TO_IDLE;
+        }
+    }
+    
+    // Profile bounds
+    if (us <= mode->burstUs)
+    {
+        us = mode->burstUs;
+        if (s_adaptiveState == POLL_STATE_ACTIVE) s_adaptiveState = POLL_STATE_BURST;
+    }
+    else if (us >= mode->idleUs)
+    {
+        us = mode->idleUs;
+        s_adaptiveState = POLL_STATE_IDLE;
+    }
+    
+    s_adaptiveInterval = us;
+
+#ifndef RELEASE
+    // Log state changes (even without interval change)
+    if (s_configByte & CONFIG_DEBUG_MODE)
+    {
+        if (oldState != s_adaptiveState)
+        {
+            DebugLogF("Predictive: [%s->%s] interval=%ldus | gap=%ldus dev=%ldus", 
+                      s_pollStateNames[oldState], s_pollStateNames[s_adaptiveState], 
+                      (LONG)us, (LONG)s_predictGap, (LONG)s_predictDev);
+        }
+    }
+#endif
+
+    return us;
+}
+
+/**
+ * Account the interval that just elapsed to the current polling state.
+ * @param micros Elapsed interval (below one second)
+ */
+static inline void daemon_StatsState(ULONG micros)
+{
+    ULONG *us = &s_shared.stats.stateMicros[s_adaptiveState];
+    
+    *us += micros;
+    if (*us >= 1000000)
+    {
+        *us -= 1000000;
+        s_shared.stats.stateSecs[s_adaptiveState]++;
+    }
+}
+
+/**
+ * Count the processing time of a tick in the log2 histogram.
+ * @param startClock EClock (low 32 bits) read when the tick started
+ */
+static inline void daemon_StatsTick(ULONG startClock)
+{
+    struct EClockVal now;
+    ULONG elapsed;
+    UBYTE bucket = 0;
+    
+    HAL_ReadClock(&now);
+    elapsed = (now.ev_lo - startClock) >> 1;
+    while (elapsed && bucket < STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        elapsed >>= 1;
+        bucket++;
+    }
+    s_shared.stats.histogram[bucket]++;
+}
+
+#ifdef CYCLE_PROFILER
+/**
+ * Read the EClock for the cycle profiler.
+ * @return EClock (low 32 bits)
+ */
+static inline ULONG daemon_CyclesClock(void)
+{
+    struct EClockVal now;
+    
+    HAL_ReadClock(&now);
+    return now.ev_lo;
+}
+
+/**
+ * Close a profiled phase: account min/max/total and the histogram.
+ * @param phase CYCLES_PHASE_*
+ * @param startClock EClock (low 32 bits) when the phase started
+ * @return EClock read now, start of the next phase
+ */
+static inline ULONG daemon_CyclesAdd(UBYTE phase, ULONG startClock)
+{
+    struct XMouseCyclePhase *p = &s_cycles.phases[phase];
+    ULONG now = daemon_CyclesClock();
+    ULONG elapsed = now - startClock;
+    ULONG v = elapsed >> 1;
+    UBYTE bucket = 0;
+    
+    if (p->count == 0 || elapsed < p->min)
+    {
+        p->min = elapsed;
+    }
+    if (elapsed > p->max)
+    {
+        p->max = elapsed;
+    }
+    p->count++;
+    p->total += elapsed;
+    
+    while (v && bucket < CYCLES_HISTOGRAM_BUCKETS - 1)
+    {
+        v >>= 1;
+        bucket++;
+    }
+    p->histogram[bucket]++;
+    
+    return now;
+}
+#endif
+
+/**
+ * Fill a ladder from an interval toward its end by a fixed step,
+ * as the former per-tick arithmetic did (last step clamped to 'to').
+ * Lengths are clamped for profiles built at run time.
+ * @param ladder Descent or ascent ladder
+ * @param last Receives the index of the 'to' entry
+ * @param from First interval (microseconds)
+ * @param to Last interval: burstUs (descent) or idleUs (ascent)
+ * @param step stepDecUs or stepIncUs
+ */
+static void daemon_LadderFill(AdaptiveStep *ladder, UBYTE *last, ULONG from, ULONG to, ULONG step)
+{
+    UWORD i;
+    ULONG us = from;
+    
+    for (i = 0; i < ADAPTIVE_LADDER_MAX - 1 && us != to; i++)
+    {
+        ladder[i].us = us;
+        ladder[i].ticks = (us * s_eclockPerUsQ12) >> 12;  // Same conversion as daemon_TimerTicks()
+        if (from > to)
+        {
+            us = (us > to + step) ? us - step : to;
+        }
+        else
+        {
+            us = (us + step < to) ? us + step : to;
+        }
+    }
+    ladder[i].us = to;
+    ladder[i].ticks = (to * s_eclockPerUsQ12) >> 12;
+    *last = (UBYTE)i;
+}
+
+/**
+ * Compile a profile into the descent/ascent ladders: descent from
+ * activeUs, ascent reduced to idleUs (the IDLE state).
+ * Called on mode change, after daemon_ClockInit() (EClock ticks).
+ * Rows are validated at build time (ADAPTIVE_PROFILE_CHECK).
+ * @param mode Profile to compile
+ */
+static void daemon_LadderBuild(const AdaptiveMode *mode)
+{
+    daemon_LadderFill(s_ladderDec, &s_ladderDecLast, mode->activeUs, mode->burstUs, mode->stepDecUs);
+    daemon_LadderFill(s_ladderInc, &s_ladderIncLast, mode->idleUs, mode->idleUs, mode->stepIncUs);
+    
+    // Inactivity thresholds per state (IDLE/TO_IDLE: not used)
+    s_adaptiveThreshold[POLL_STATE_IDLE] = 0xFFFFFFFF;
+    s_adaptiveThreshold[POLL_STATE_ACTIVE] = mode->activeThreshold;
+    s_adaptiveThreshold[POLL_STATE_BURST] = mode->idleThreshold;
+    s_adaptiveThreshold[POLL_STATE_TO_IDLE] = 0xFFFFFFFF;
+}
+
+#ifndef XMOUSED_HOST
+/**
+ * Initialize daemon resources.
+ * @return TRUE on success, FALSE on failure.
+ */
+static inline BOOL daemon_Init(void)
+{
+    MouseSample sample;
+    UBYTE i;
+    
+    SysBase = *(struct ExecBase **)4L;
+    DOSBase = (struct DosLibrary *)OpenLibrary("dos.library", 36);
+    if (!DOSBase)
+    {
+        return FALSE;
+    }
+
+    // Create our public port, extended with the shared block
+    if (!daemon_PortCreate())
+    {
+        return FALSE;
+    }
+    
+    // Free event pools a previous daemon left to slow subscribers
+    subscribeOrphansReap();
+
+    // Create input device for event injection    
+    s_InputPort = CreateMsgPort();
+    if (!s_InputPort)
+    {
+        return FALSE;
+    }
+    s_InputReq = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
+    if (!s_InputReq)
+    {
+        DeleteMsgPort(s_InputPort);
+        s_InputPort = NULL;
+        return FALSE;
+    }
+    if (OpenDevice("input.device", 0, (struct IORequest *)s_InputReq, 0))
+    {
+        DeleteIORequest((struct IORequest *)s_InputReq);
+        DeleteMsgPort(s_InputPort);
+        s_InputPort = NULL;
+        s_InputReq = NULL;
+        return FALSE;
+    }
+    
+    // Get InputBase from the opened device for PeekQualifier inline pragma
+    InputBase = s_InputReq->io_Device;
+    
+    // Injection ring: slot 0 uses s_InputReq, others share its device/unit
+    s_injectRing[0].req = s_InputReq;
+    for (i = 1; i < INJECT_RING_SIZE; i++)
+    {
+        s_injectRing[i].req = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
+        if (!s_injectRing[i].req)
+        {
+            return FALSE;
+        }
+        s_injectRing[i].req->io_Device = s_InputReq->io_Device;
+        s_injectRing[i].req->io_Unit = s_InputReq->io_Unit;
+    }
+
+    // Create Timer for polling
+    s_TimerPort = CreateMsgPort();
+    if (!s_TimerPort)
+    {
+        return FALSE;
+    }
+    s_TimerReq = (struct timerequest *)CreateIORequest(s_TimerPort, sizeof(struct timerequest));
+    if (!s_TimerReq)
+    {
+        DeleteMsgPort(s_TimerPort);
+        s_TimerPort = NULL;
+        return FALSE;
+    }
+    if (!daemon_TimerOpen((UBYTE)((s_options & OPT_TIMER_UNIT_MASK) >> OPT_TIMER_UNIT_SHIFT)))
+    {
+        DeleteIORequest((struct IORequest *)s_TimerReq);
+        DeleteMsgPort(s_TimerPort);
+        s_TimerPort = NULL;
+        s_TimerReq = NULL;
+        return FALSE;
+    }
+
+    // Initialize hardware state to avoid false initial events
+    daemon_DecodeSample(HAL_ReadRegister(), &sample);
+    s_lastBTState = sample.buttons;
+    s_lastWHCounter = sample.wheel;
+    s_lastWHDelta = 0;
+    //s_lastWHDir = 0;
+    
+    // Ensure config byte and poll interval are set
+    if (s_configByte == 0)
+    {
+        s_configByte = DEFAULT_CONFIG_BYTE;
+    }
+    
+    // User profiles (optional file)
+    daemon_ProfileLoad();
+    
+    // Initialize adaptive polling system
+    daemon_ApplyMode();
+
+    return TRUE;
+}
+
+/**
+ * Cleanup daemon resources
+ */
+static inline void daemon_Cleanup(void)
+{
+    UBYTE i;
+
+    // Remove interrupt samplers and input handlers before anything they reference
+    daemon_VblStop();
+    daemon_CiaStop();
+    daemon_PrewarmStop();
+    daemon_SmoothStop();
+    if (s_InputReq && s_InputReq->io_Device)
+    {
+        injectHandlerStop();
+    }
+    subscribeStop();
+    
+    // Save the capture while DOS is still open
+    daemon_TraceStop();
+
+#ifndef RELEASE
+    // Stop logger: pending records are printed first
+    daemon_LogStop();
+#endif
+
+    // Cleanup timer: abort pending request, close device, delete resources
+    if (s_TimerReq)
+    {
+        if (s_TimerReq->tr_node.io_Device)
+        {
+            if (CheckIO((struct IORequest *)s_TimerReq) == NULL)
+            {
+                AbortIO((struct IORequest *)s_TimerReq);
+                WaitIO((struct IORequest *)s_TimerReq);
+            }
+            CloseDevice((struct IORequest *)s_TimerReq);
+        }
+        DeleteIORequest((struct IORequest *)s_TimerReq);
+    }
+    if (s_TimerPort)
+    {
+        DeleteMsgPort(s_TimerPort);
+    }
+
+    // cleanup input device: wait for async injections, delete ring requests
+    if (s_InputReq && s_InputReq->io_Device)
+    {
+        injectDrain();
+    }
+    for (i = 1; i < INJECT_RING_SIZE; i++)
+    {
+        if (s_injectRing[i].req)
+        {
+            DeleteIORequest((struct IORequest *)s_injectRing[i].req);
+            s_injectRing[i].req = NULL;
+        }
+    }
+    if (s_InputReq)
+    {
+        if (s_InputReq->io_Device)
+        {
+            CloseDevice((struct IORequest *)s_InputReq);
+        }
+        DeleteIORequest((struct IORequest *)s_InputReq);
+    }
+    if (s_InputPort)
+    {
+        DeleteMsgPort(s_InputPort);
+    }
+
+    // cleanup public port
+    daemon_PortDelete();
+
+    // cleanup DOS library
+    if (DOSBase)
+    {
+        CloseLibrary((struct Library *)DOSBase);
+    }
+}
+
+/**
+ * Create the public port with the shared block pointer appended.
+ * Built by hand because CreateMsgPort() can't allocate the larger struct.
+ * @return TRUE on success, FALSE on failure.
+ */
+static BOOL daemon_PortCreate(void)
+{
+    struct XMousePort *xport;
+    BYTE sigBit;
+    
+    sigBit = AllocSignal(-1);
+    if (sigBit == -1)
+    {
+        return FALSE;
+    }
+    
+    xport = (struct XMousePort *)AllocMem(sizeof(struct XMousePort), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!xport)
+    {
+        FreeSignal(sigBit);
+        return FALSE;
+    }
+    
+    xport->port.mp_Node.ln_Type = NT_MSGPORT;
+    xport->port.mp_Node.ln_Name = DAEMON_PORT_NAME;
+    xport->port.mp_Node.ln_Pri = 0;
+    xport->port.mp_Flags = PA_SIGNAL;
+    xport->port.mp_SigBit = (UBYTE)sigBit;
+    xport->port.mp_SigTask = FindTask(NULL);
+    xport->port.mp_MsgList.lh_Head = (struct Node *)&xport->port.mp_MsgList.lh_Tail;
+    xport->port.mp_MsgList.lh_Tail = NULL;
+    xport->port.mp_MsgList.lh_TailPred = (struct Node *)&xport->port.mp_MsgList.lh_Head;
+    
+    s_shared.version = XMOUSE_SHARED_VERSION;
+    s_shared.size = sizeof(struct XMouseShared);
+    s_shared.stats.version = XMOUSE_STATS_VERSION;
+    s_shared.stats.size = sizeof(struct XMouseStats);
+    xport->magic = XMOUSE_PORT_MAGIC;
+    xport->shared = &s_shared;
+    
+    s_PublicPort = &xport->port;
+    AddPort(s_PublicPort);
+    return TRUE;
+}
+
+/**
+ * Remove and free the public port.
+ * Messages still queued are answered with an error (abandoned requests
+ * freed), so no client waits for a reply that never comes.
+ * Clients must not touch the shared block once FindPort() fails.
+ */
+static void daemon_PortDelete(void)
+{
+    struct XMouseMsg *msg;
+    
+    if (s_PublicPort)
+    {
+        Forbid();
+        RemPort(s_PublicPort);
+        while ((msg = (struct XMouseMsg *)GetMsg(s_PublicPort)))
+        {
+            msg->result = 0xFFFFFFFF;
+            if (msg->command == XMSG_CMD_REQUEST)
+            {
+                struct XMouseRequest *req = (struct XMouseRequest *)msg;
+                
+                if (req->state == XMREQ_STATE_ABANDONED || (req->flags & XMREQ_FLAG_NOREPLY))
+                {
+                    FreeMem(req, msg->msg.mn_Length);
+                    continue;
+                }
+                req->state = XMREQ_STATE_DONE;
+            }
+            ReplyMsg((struct Message *)msg);
+        }
+        Permit();
+        FreeSignal(s_PublicPort->mp_SigBit);
+        FreeMem(s_PublicPort, sizeof(struct XMousePort));
+        s_PublicPort = NULL;
+    }
+}
+
+#ifndef RELEASE
+/**
+ * Queue a debug record (called through DebugLog/DebugLogF).
+ * Copies the format pointer and LOG_ARGS_MAX argument words: unused
+ * words are read from the caller's stack and ignored by the format.
+ * Counted as dropped when the logger is behind.
+ * @param fmt Format string, valid until printed
+ */
+static void debugLogPush(const char *fmt, ...)
+{
+    LogRing *ring = &s_logRing;
+    UBYTE head = ring->head;
+    UBYTE next = (head + 1) & (LOG_RING_SIZE - 1);
+    volatile LogRecord *rec;
+    va_list ap;
+    UBYTE i;
+    
+    if (next == ring->tail)
+    {
+        ring->dropped++;
+        return;
+    }
+    
+    rec = &ring->records[head];
+    rec->fmt = fmt;
+    va_start(ap, fmt);
+    for (i = 0; i < LOG_ARGS_MAX; i++)
+    {
+        rec->args[i] = va_arg(ap, ULONG);
+    }
+    va_end(ap);
+    
+    ring->head = next;
+}
+
+/**
+ * Logger process: open the debug console, print queued records every
+ * LOG_DRAIN_TICKS until CTRL-C, then drain once more and exit.
+ */
+static void daemon_Logger(void)
+{
+    LogRing *ring = &s_logRing;
+    ULONG reported = 0;
+    BOOL quit = FALSE;
+    BPTR con;
+    UBYTE tail;
+    
+    con = Open(LOG_CON_NAME, MODE_NEWFILE);
+    
+    while (!quit)
+    {
+        quit = (CheckSignal(SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) != 0;
+        
+        tail = ring->tail;
+        while (tail != ring->head)
+        {
+            if (con)
+            {
+                VFPrintf(con, ring->records[tail].fmt, (const void *)ring->records[tail].args);
+            }
+            tail = (tail + 1) & (LOG_RING_SIZE - 1);
+            ring->tail = tail;
+        }
+        
+        if (ring->dropped != reported)
+        {
+            reported = ring->dropped;
+            if (con)
+            {
+                FPrintf(con, "Log: %ld record(s) dropped\n", (LONG)reported);
+            }
+        }
+        
+        if (con)
+        {
+            Flush(con);
+        }
+        if (!quit)
+        {
+            Delay(LOG_DRAIN_TICKS);
+        }
+    }
+    
+    if (con)
+    {
+        Close(con);
+    }
+    
+    // Signal under Forbid: the daemon can't free anything before we're gone
+    Forbid();
+    Signal(ring->owner, 1L << ring->doneSigBit);
+}
+
+/**
+ * Start the logger process (debug mode enabled).
+ * Debug output stays off if the process can't be created.
+ */
+static void daemon_LogStart(void)
+{
+    LogRing *ring = &s_logRing;
+    
+    if (ring->logger) return;
+    
+    ring->doneSigBit = AllocSignal(-1);
+    if (ring->doneSigBit == -1) return;
+    
+    ring->owner = FindTask(NULL);
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->logger = (struct Task *)CreateNewProcTags(
+        NP_Entry, (ULONG)daemon_Logger,
+        NP_Name, (ULONG)LOG_TASK_NAME,
+        NP_Priority, LOG_TASK_PRI,
+        TAG_DONE);
+    
+    if (!ring->logger)
+    {
+        FreeSignal(ring->doneSigBit);
+        ring->doneSigBit = -1;
+    }
+}
+
+/**
+ * Stop the logger process and wait until it has printed pending
+ * records, closed the console and exited.
+ */
+static void daemon_LogStop(void)
+{
+    LogRing *ring = &s_logRing;
+    
+    if (!ring->logger) return;
+    
+    Signal(ring->logger, SIGBREAKF_CTRL_C);
+    Wait(1L << ring->doneSigBit);
+    
+    ring->logger = NULL;
+    FreeSignal(ring->doneSigBit);
+    ring->doneSigBit = -1;
+}
+#endif
+
+#endif // XMOUSED_HOST
+
+/**
+ * Register bits to watch for the current config.
+ * @return Mask of wheel and/or button bits in SAGA register
+ */
+static inline UWORD daemon_SampleMask(void)
+{
+    return ((s_configByte & CONFIG_WHEEL_ENABLED) ? SAGA_WHEEL_MASK : 0) |
+           ((s_configByte & CONFIG_BUTTONS_ENABLED) ? SAGA_BUTTONS_MASK : 0);
+}
+
+#ifndef XMOUSED_HOST
+/**
+ * VBL interrupt server: one register read per frame.
+ * Pushes the sample and signals the daemon only if it changed.
+ * @param mb Mailbox (is_Data)
+ * @return 0 (Z flag set, continue server chain)
+ */
+static ULONG __saveds vblServer(__reg("a1") VblMailbox *mb)
+{
+    UWORD raw = HAL_ReadRegister() & mb->mask;
+    
+    if (raw != mb->last)
+    {
+        UBYTE next = (mb->head + 1) & (VBL_MAILBOX_SIZE - 1);
+        
+        mb->last = raw;
+        if (next != mb->tail)
         {
-            PrintF(MSG_DAEMON_RUNNING, status);
+            mb->samples[mb->head] = raw;
+            mb->head = next;
         }
         else
         {
-            Print(MSG_ERR_GET_STATUS_FAILED);
-            exitCode = RETURN_FAIL;
+            // Full: the wheel counter is absolute, so a wheel-only entry can
+            // be merged away, but a button change must be kept
+            UBYTE tail = mb->tail;
+            UBYTE newest = (mb->head - 1) & (VBL_MAILBOX_SIZE - 1);
+            UBYTE i = newest;
+            
+            if ((mb->samples[newest] ^ raw) & SAGA_BUTTONS_MASK)
+            {
+                // Drop the newest wheel-only entry (never the tail: daemon may be reading it)
+                while (i != tail &&
+                       ((mb->samples[i] ^ mb->samples[(i - 1) & (VBL_MAILBOX_SIZE - 1)]) & SAGA_BUTTONS_MASK))
+                {
+                    i = (i - 1) & (VBL_MAILBOX_SIZE - 1);
+                }
+                if (i == tail)
+                {
+                    i = newest;  // Only button changes: newest is replaced, final state kept
+                }
+                for (; i != newest; i = (i + 1) & (VBL_MAILBOX_SIZE - 1))
+                {
+                    mb->samples[i] = mb->samples[(i + 1) & (VBL_MAILBOX_SIZE - 1)];
+                }
+            }
+            mb->samples[newest] = raw;
         }
-        
-        goto cleanup;
+        Signal(mb->task, mb->signal);
     }
+    return 0;
+}
 
-    if (startMode == START_MODE_CONFIG && existingPort)
+/**
+ * Install the VBL interrupt server.
+ * Caller stops the polling timer on success.
+ * @return TRUE on success, FALSE if no signal bit is available
+ */
+static BOOL daemon_VblStart(void)
+{
+    VblMailbox *mb = &s_vblMailbox;
+    
+    s_vblSigBit = AllocSignal(-1);
+    if (s_vblSigBit < 0)
     {
-        ULONG result = sendDaemonMessage(existingPort, XMSG_CMD_SET_CONFIG, s_configByte);
-        if (result == 0)
-        {
-            // Always log in dev builds
-            PrintF(MSG_CONFIG_UPDATED, (ULONG)s_configByte);
-        }
-        else
-        {
-            Print(MSG_ERR_UPDATE_CONFIG);
-            exitCode = RETURN_FAIL;
-        }
-        goto cleanup;
+        DebugLog("VBL: no free signal, timer polling kept");
+        return FALSE;
     }
     
-    if ((startMode == START_MODE_STOP || startMode == START_MODE_TOGGLE) && existingPort)
+    mb->task = FindTask(NULL);
+    mb->signal = 1L << s_vblSigBit;
+    mb->mask = daemon_SampleMask();
+    mb->last = ((UWORD)s_lastBTState | (UBYTE)s_lastWHCounter) & mb->mask;
+    mb->head = 0;
+    mb->tail = 0;
+    
+    s_vblInterrupt.is_Node.ln_Type = NT_INTERRUPT;
+    s_vblInterrupt.is_Node.ln_Pri = VBL_SERVER_PRI;
+    s_vblInterrupt.is_Node.ln_Name = DAEMON_DESC_SHORT;
+    s_vblInterrupt.is_Data = (APTR)mb;
+    s_vblInterrupt.is_Code = (void (*)())vblServer;
+    AddIntServer(INTB_VERTB, &s_vblInterrupt);
+    
+    s_vblSignal = mb->signal;
+    
+    DebugLog("Sampling: VBL interrupt");
+    return TRUE;
+}
+
+/**
+ * Remove the VBL interrupt server and release its signal.
+ * Caller restarts the polling timer.
+ */
+static void daemon_VblStop(void)
+{
+    if (!s_vblSignal) return;
+    
+    RemIntServer(INTB_VERTB, &s_vblInterrupt);
+    FreeSignal(s_vblSigBit);
+    s_vblSigBit = -1;
+    s_vblSignal = 0;
+    
+    DebugLog("Sampling: timer");
+}
+
+/**
+ * CIA timer interrupt: one register read per period.
+ * Sums wheel movement, queues button changes with the wheel total at
+ * that moment, signals the daemon once per drain.
+ * @param cs Sampler (is_Data)
+ */
+static void __saveds ciaServer(__reg("a1") CiaSampler *cs)
+{
+    UWORD raw = HAL_ReadRegister() & cs->mask;
+    UWORD changed = raw ^ cs->last;
+    
+    cs->samples++;
+    if (!changed && !cs->overflow) return;
+    
+    // Signed 8-bit step: no aliasing at 1kHz and above
+    cs->wheelTotal += (LONG)(BYTE)((UBYTE)raw - (UBYTE)cs->last);
+    
+    if ((changed & SAGA_BUTTONS_MASK) || cs->overflow)
     {
-        ULONG result;
-        
-        // Send QUIT message to daemon
-        result = sendDaemonMessage(existingPort, XMSG_CMD_QUIT, 0);
+        UBYTE head = cs->head;
+        UBYTE next = (head + 1) & (CIA_EDGE_RING_SIZE - 1);
         
-        if (result == 0)
+        if (next == cs->tail)
         {
-            Print(MSG_DAEMON_STOPPED);
+            // Full: queued changes are kept, the state catches up after the drain
+            cs->overflow = 1;
         }
         else
         {
-            Print(MSG_ERR_STOP_DAEMON);
-            exitCode = RETURN_FAIL;
+            cs->edgeButtons[head] = raw & SAGA_BUTTONS_MASK;
+            cs->edgeWheel[head] = cs->wheelTotal;
+            cs->head = next;
+            cs->overflow = 0;
         }
-        goto cleanup;
     }
+    
+    cs->last = raw;
+    if (!cs->signalled)
+    {
+        cs->signalled = 1;
+        Signal(cs->task, cs->signal);
+    }
+}
 
-    // Create background process using WBM pattern
-    if (CreateNewProcTags(
-        NP_Entry, (ULONG)daemon,
-        NP_Name, (ULONG)DAEMON_DESC_SHORT,
-        NP_Priority, 0,
-        TAG_DONE))
+/**
+ * Program the first free CIA timer for the given rate and install
+ * ciaServer(). Tries CIA-B timer A, CIA-B timer B, then CIA-A timer B
+ * (CIA-A timer A belongs to the keyboard).
+ * @param rate Rate index (CIA_RATE_HZ)
+ * @return TRUE on success, FALSE if no signal or timer is available
+ */
+static BOOL daemon_CiaStart(UBYTE rate)
+{
+    static const char * const names[3] = { CIABNAME, CIABNAME, CIAANAME };
+    static const UBYTE bits[3] = { CIAICRB_TA, CIAICRB_TB, CIAICRB_TB };
+    CiaSampler *cs = &s_ciaSampler;
+    struct Library *resource;
+    ULONG period;
+    UBYTE i;
+    
+    if (s_ciaSignal) return TRUE;
+    
+    s_ciaSigBit = AllocSignal(-1);
+    if (s_ciaSigBit < 0)
     {
-        // Detach from shell by clearing CLI module - WBM pattern
-        proc = (struct Process *)FindTask(NULL);
-        if (proc->pr_CLI)
+        DebugLog("CIA: no free signal");
+        return FALSE;
+    }
+    
+    cs->task = FindTask(NULL);
+    cs->signal = 1L << s_ciaSigBit;
+    cs->mask = daemon_SampleMask();
+    cs->last = ((UWORD)s_lastBTState | (UBYTE)s_lastWHCounter) & cs->mask;
+    cs->wheelTotal = 0;
+    cs->head = 0;
+    cs->tail = 0;
+    cs->signalled = 0;
+    cs->overflow = 0;
+    cs->samples = 0;
+    s_ciaWheelTaken = 0;
+    
+    s_ciaInterrupt.is_Node.ln_Type = NT_INTERRUPT;
+    s_ciaInterrupt.is_Node.ln_Pri = 0;
+    s_ciaInterrupt.is_Node.ln_Name = DAEMON_DESC_SHORT;
+    s_ciaInterrupt.is_Data = (APTR)cs;
+    s_ciaInterrupt.is_Code = (void (*)())ciaServer;
+    
+    for (i = 0; i < 3; i++)
+    {
+        resource = (struct Library *)OpenResource(names[i]);
+        if (resource && !AddICRVector(resource, bits[i], &s_ciaInterrupt))
         {
-            cli = BADDR(proc->pr_CLI);
-            cli->cli_Module = 0;
+            break;
         }
+    }
+    if (i == 3)
+    {
+        FreeSignal(s_ciaSigBit);
+        s_ciaSigBit = -1;
+        DebugLog("CIA: no free timer");
+        return FALSE;
+    }
+    
+    s_ciaResource = resource;
+    s_ciaHw = (i == 2) ? CIAA_BASE : CIAB_BASE;
+    s_ciaTimerB = (bits[i] == CIAICRB_TB);
+    
+    // Continuous mode, counting EClock ticks (the CIA clock)
+    period = s_eclockFreq / CIA_RATE_HZ(rate);
+    if (s_ciaTimerB)
+    {
+        s_ciaHw->ciacrb &= ~(CIACRBF_START | CIACRBF_RUNMODE | CIACRBF_INMODE0 | CIACRBF_INMODE1);
+        s_ciaHw->ciatblo = (UBYTE)period;
+        s_ciaHw->ciatbhi = (UBYTE)(period >> 8);
+        s_ciaHw->ciacrb |= CIACRBF_LOAD | CIACRBF_START;
+    }
+    else
+    {
+        s_ciaHw->ciacra &= ~(CIACRAF_START | CIACRAF_RUNMODE | CIACRAF_INMODE);
+        s_ciaHw->ciatalo = (UBYTE)period;
+        s_ciaHw->ciatahi = (UBYTE)(period >> 8);
+        s_ciaHw->ciacra |= CIACRAF_LOAD | CIACRAF_START;
+    }
+    
+    s_ciaSignal = cs->signal;
+    
+    DebugLogF("Sampling: CIA %ldHz", (LONG)CIA_RATE_HZ(rate));
+    return TRUE;
+}
 
-        // Start the daemon
-        PrintF(MSG_DAEMON_RUNNING, (ULONG)s_configByte);
-
-        goto cleanup;
+/**
+ * Stop the CIA timer, remove the interrupt and release its signal.
+ * Caller restarts the polling timer.
+ */
+static void daemon_CiaStop(void)
+{
+    UBYTE bit;
+    
+    if (!s_ciaSignal) return;
+    
+    if (s_ciaTimerB)
+    {
+        s_ciaHw->ciacrb &= ~CIACRBF_START;
+        bit = CIAICRB_TB;
+    }
+    else
+    {
+        s_ciaHw->ciacra &= ~CIACRAF_START;
+        bit = CIAICRB_TA;
     }
+    AbleICR(s_ciaResource, 1 << bit);
+    RemICRVector(s_ciaResource, bit, &s_ciaInterrupt);
+    s_ciaResource = NULL;
     
-    Print(MSG_DAEMON_START_FAILED);
-    exitCode = RETURN_FAIL;
+    // No stale wakeup for whoever gets the bit next
+    SetSignal(0, s_ciaSignal);
+    FreeSignal(s_ciaSigBit);
+    s_ciaSigBit = -1;
+    s_ciaSignal = 0;
+    
+    DebugLog("Sampling: CIA stopped");
+}
 
-cleanup:
-    if (DOSBase)
+/**
+ * Select the sampling source for an options word: CIA (bit 9) first,
+ * then VBL (bit 3). Caller starts or stops the polling timer.
+ * @param options OPT_* flags
+ */
+static void daemon_SamplingApply(ULONG options)
+{
+    daemon_CiaStop();
+    daemon_VblStop();
+    
+    if ((options & OPT_CIA_SAMPLING) && daemon_CiaStart(OPT_CIA_RATE(options)))
     {
-        CloseLibrary((struct Library *)DOSBase);
+        // CIA active
     }
-    return exitCode;
+    else if (options & OPT_VBL_SAMPLING)
+    {
+        daemon_VblStart();
+    }
+    
+    // Capture with timer polling gets its own sampler
+    daemon_TraceSamplerUpdate();
 }
 
 /**
- * Send a message to the daemon and wait for reply with timeout.
- * If daemon doesn't reply within 2 seconds, returns FALSE.
- * @param port Daemon's public port
- * @param cmd Command to send
- * @param value Command parameter
- * @return TRUE on success, FALSE on timeout/error
+ * Busy loop for a number of EClock ticks.
+ * @param ticks Loop length
+ * @return Iterations done (higher = more CPU left)
  */
-static ULONG sendDaemonMessage(struct MsgPort *port, UBYTE cmd, ULONG value)
+static ULONG daemon_CiaSpin(ULONG ticks)
 {
-    struct MsgPort *replyPort = NULL;
-    struct XMouseMsg *msg = NULL;
-    struct MsgPort *timerPort = NULL;
-    struct timerequest *timerReq = NULL;
-    ULONG result = 0xFFFFFFFF;  // Error by default
-    ULONG replySig, timerSig, signals;
+    struct EClockVal start, now;
+    volatile ULONG loops = 0;
+    UWORD i;
     
-    // Create reply port
-    replyPort = CreateMsgPort();
-    if (!replyPort)
+    ReadEClock(&start);
+    do
     {
-        goto cleanup;
+        for (i = 0; i < 256; i++)
+        {
+            loops++;
+        }
+        ReadEClock(&now);
+    } while (now.ev_lo - start.ev_lo < ticks);
+    
+    return loops;
+}
+
+/**
+ * CIA sampler CPU cost: a busy loop without sampler, then at each rate,
+ * with multitasking off. The loss of iterations is the CPU taken by the
+ * interrupt, entry and exit included. The daemon's own sampler is
+ * restored afterwards.
+ * @param cost Result buffer, 'size' set by the sender
+ * @return CIA_COST_VERSION, 0xFFFFFFFF on error
+ */
+static ULONG daemon_BenchCia(struct XMouseCiaCost *cost)
+{
+    struct XMouseCiaCost result;
+    ULONG window = s_eclockFreq / (1000000 / CIA_COST_WINDOW_US);
+    ULONG loops;
+    BOOL wasRunning = (s_ciaSignal != 0);
+    BOOL ok = TRUE;
+    UWORD size;
+    UBYTE rate;
+    
+    if (!cost || cost->size < 2 * sizeof(UWORD))
+    {
+        return 0xFFFFFFFF;
     }
     
-    // Create timer for timeout (2 seconds)
-    timerPort = CreateMsgPort();
-    if (!timerPort)
+    daemon_CiaStop();
+    
+    Forbid();
+    result.baseLoops = daemon_CiaSpin(window);
+    for (rate = 0; rate < CIA_RATE_COUNT && ok; rate++)
     {
-        goto cleanup;
+        result.rateHz[rate] = CIA_RATE_HZ(rate);
+        ok = daemon_CiaStart(rate);
+        if (ok)
+        {
+            loops = daemon_CiaSpin(window);
+            result.samplesPerSec[rate] = s_ciaSampler.samples * (1000000 / CIA_COST_WINDOW_US);
+            daemon_CiaStop();
+            result.costPermille[rate] = (result.baseLoops > loops && result.baseLoops >= 1000) ?
+                                        (result.baseLoops - loops) / (result.baseLoops / 1000) : 0;
+        }
     }
-    timerReq = (struct timerequest *)CreateIORequest(timerPort, sizeof(struct timerequest));
-    if (!timerReq)
+    Permit();
+    
+    if (wasRunning)
     {
-        goto cleanup;
+        daemon_CiaStart(OPT_CIA_RATE(s_options));
     }
-    if (OpenDevice(TIMERNAME, UNIT_VBLANK, (struct IORequest *)timerReq, 0))
+    if (!ok)
     {
-        goto cleanup;
+        return 0xFFFFFFFF;
     }
     
-    // Allocate message
-    msg = (struct XMouseMsg *)AllocMem(sizeof(struct XMouseMsg), MEMF_PUBLIC | MEMF_CLEAR);
-    if (!msg)
+    result.version = CIA_COST_VERSION;
+    result.windowUs = CIA_COST_WINDOW_US;
+    size = (cost->size < sizeof(result)) ? cost->size : sizeof(result);
+    result.size = size;
+    CopyMem(&result, cost, size);
+    
+    return CIA_COST_VERSION;
+}
+
+/**
+ * Register a client port (XMSG_CMD_SUBSCRIBE).
+ * The event pool is allocated here, events are only recycled afterwards.
+ * @param sub Request, owned by the sender until reply
+ * @return SUBSCRIBE_VERSION, 0xFFFFFFFF if invalid, already subscribed or no room
+ */
+static ULONG subscribeAdd(struct XMouseSubscribe *sub)
+{
+    Subscriber *slot = NULL;
+    UBYTE i;
+    
+    if (!sub || sub->size < sizeof(struct XMouseSubscribe) || !sub->port)
     {
-        goto cleanup;
+        return 0xFFFFFFFF;
     }
     
-    // Setup message
-    msg->msg.mn_Node.ln_Type = NT_MESSAGE;
-    msg->msg.mn_Length = sizeof(struct XMouseMsg);
-    msg->msg.mn_ReplyPort = replyPort;
-    msg->command = cmd;
-    msg->value = value;
+    for (i = 0; i < SUBSCRIBERS_MAX; i++)
+    {
+        if (s_subscribers[i].port == sub->port)
+        {
+            return 0xFFFFFFFF;
+        }
+        if (!slot && !s_subscribers[i].pool)
+        {
+            slot = &s_subscribers[i];
+        }
+    }
+    if (!slot)
+    {
+        return 0xFFFFFFFF;
+    }
     
-    // Send message to daemon
-    PutMsg(port, (struct Message *)msg);
+    if (!s_subscribePort)
+    {
+        s_subscribePort = subscribePortCreate();
+        if (!s_subscribePort)
+        {
+            return 0xFFFFFFFF;
+        }
+        s_subscribeSignal = 1L << s_subscribePort->mp_SigBit;
+    }
     
-    // Setup timeout: 2 seconds
-    timerReq->tr_node.io_Command = TR_ADDREQUEST;
-    timerReq->tr_time.tv_secs = DAEMON_REPLY_TIMEOUT;
-    timerReq->tr_time.tv_micro = 0;
-    SendIO((struct IORequest *)timerReq);
+    slot->pool = (struct XMouseEvent *)AllocMem(SUBSCRIBE_POOL_SIZE * sizeof(struct XMouseEvent), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!slot->pool)
+    {
+        subscribeReap();  // Deletes the reply port if unused
+        return 0xFFFFFFFF;
+    }
     
-    // Wait for reply OR timeout
-    replySig = 1L << replyPort->mp_SigBit;
-    timerSig = 1L << timerPort->mp_SigBit;
-    signals = Wait(replySig | timerSig);
+    for (i = 0; i < SUBSCRIBE_POOL_SIZE; i++)
+    {
+        slot->pool[i].msg.mn_Node.ln_Type = NT_MESSAGE;
+        slot->pool[i].msg.mn_Length = sizeof(struct XMouseEvent);
+        slot->pool[i].msg.mn_ReplyPort = s_subscribePort;
+        slot->freeList[i] = i;
+    }
+    slot->freeCount = SUBSCRIBE_POOL_SIZE;
+    slot->flags = (UBYTE)sub->flags;
+    slot->dropped = 0;
+    slot->port = sub->port;
     
-    if (signals & replySig)
+    s_subscriberCount++;
+    if (slot->flags & SUBSCRIBE_NO_INJECT)
     {
-        // Reply received before timeout
-        GetMsg(replyPort);
-        result = msg->result;  // Return daemon's result
-        
-        // Abort timer
-        AbortIO((struct IORequest *)timerReq);
-        WaitIO((struct IORequest *)timerReq);
+        s_subscribeExclusive++;
     }
-    else if (signals & timerSig)
+    
+    DebugLogF("Subscribe: port 0x%08lx%s", (ULONG)sub->port,
+              (slot->flags & SUBSCRIBE_NO_INJECT) ? " (no injection)" : "");
+    
+    sub->version = SUBSCRIBE_VERSION;
+    return SUBSCRIBE_VERSION;
+}
+
+/**
+ * Unregister a client port (XMSG_CMD_UNSUBSCRIBE).
+ * The pool is freed once every event sent has been replied.
+ * @param port Client port given to subscribeAdd()
+ * @return 0, 0xFFFFFFFF if not subscribed
+ */
+static ULONG subscribeRemove(struct MsgPort *port)
+{
+    UBYTE i;
+    
+    for (i = 0; i < SUBSCRIBERS_MAX; i++)
     {
-        // Timeout: daemon didn't respond
-        GetMsg(timerPort);
-        Print(MSG_ERR_DAEMON_TIMEOUT);
-        result = 0xFFFFFFFF;  // Timeout error
-        // Message is still pending in daemon - nothing we can do
+        Subscriber *slot = &s_subscribers[i];
+        
+        if (port && slot->port == port)
+        {
+            slot->port = NULL;
+            s_subscriberCount--;
+            if (slot->flags & SUBSCRIBE_NO_INJECT)
+            {
+                s_subscribeExclusive--;
+            }
+            
+            DebugLogF("Unsubscribe: port 0x%08lx, %ld event(s) out", (ULONG)port,
+                      (LONG)(SUBSCRIBE_POOL_SIZE - slot->freeCount));
+            
+            subscribeReap();
+            return 0;
+        }
     }
+    
+    return 0xFFFFFFFF;
+}
 
-cleanup:
-    // Cleanup resources (safe even if NULL)
-    if (msg)
+/**
+ * Send an event to every subscriber (tick context, never waits).
+ * @param code NewMouse code (SUBSCRIBE_CODE_CLOSED at exit)
+ * @param delta Wheel detents, 0 for buttons
+ * @return TRUE if a subscriber asked for no injection
+ */
+static BOOL subscribePost(UWORD code, WORD delta)
+{
+    struct EClockVal now;
+    struct XMouseEvent *ev;
+    UBYTE i;
+    
+    HAL_ReadClock(&now);
+    
+    for (i = 0; i < SUBSCRIBERS_MAX; i++)
     {
-        FreeMem(msg, sizeof(struct XMouseMsg));
+        Subscriber *slot = &s_subscribers[i];
+        
+        if (!slot->port)
+        {
+            continue;
+        }
+        if (!slot->freeCount)
+        {
+            slot->dropped++;
+            continue;
+        }
+        
+        ev = &slot->pool[slot->freeList[--slot->freeCount]];
+        ev->code = code;
+        ev->delta = delta;
+        ev->clock = now.ev_lo;
+        ev->dropped = slot->dropped;
+        slot->dropped = 0;
+        PutMsg(slot->port, (struct Message *)ev);
     }
-    if (timerReq)
+    
+    return s_subscribeExclusive != 0;
+}
+
+/**
+ * Take back replied events. Pools of unsubscribed clients are freed
+ * when complete, the reply port when no pool is left.
+ */
+static void subscribeReap(void)
+{
+    struct XMouseEvent *ev;
+    BOOL inUse = FALSE;
+    UBYTE i;
+    
+    if (!s_subscribePort) return;
+    
+    while ((ev = (struct XMouseEvent *)GetMsg(s_subscribePort)))
     {
-        if (timerReq->tr_node.io_Device)
+        for (i = 0; i < SUBSCRIBERS_MAX; i++)
         {
-            CloseDevice((struct IORequest *)timerReq);
+            Subscriber *slot = &s_subscribers[i];
+            
+            if (slot->pool && ev >= slot->pool && ev < slot->pool + SUBSCRIBE_POOL_SIZE)
+            {
+                slot->freeList[slot->freeCount++] = (UBYTE)(ev - slot->pool);
+                break;
+            }
         }
-        DeleteIORequest((struct IORequest *)timerReq);
     }
-    if (timerPort)
+    
+    for (i = 0; i < SUBSCRIBERS_MAX; i++)
     {
-        DeleteMsgPort(timerPort);
+        Subscriber *slot = &s_subscribers[i];
+        
+        if (slot->pool && !slot->port && slot->freeCount == SUBSCRIBE_POOL_SIZE)
+        {
+            FreeMem(slot->pool, SUBSCRIBE_POOL_SIZE * sizeof(struct XMouseEvent));
+            slot->pool = NULL;
+        }
+        inUse |= (slot->pool != NULL);
     }
-    if (replyPort)
+    
+    if (!inUse)
     {
-        DeleteMsgPort(replyPort);
+        FreeSignal(s_subscribePort->mp_SigBit);
+        FreeMem(s_subscribePort, sizeof(SubscribePort));
+        s_subscribePort = NULL;
+        s_subscribeSignal = 0;
     }
-    
-    return result;
 }
 
 /**
- * Parse command line arguments and determine start mode.
- * Also parses optional config byte in hex format (0xBYTE).
- * @return START_MODE_START, START_MODE_STOP, or START_MODE_TOGGLE.
+ * Unsubscribe everyone at exit, with a SUBSCRIBE_CODE_CLOSED event.
+ * Events still held by clients are waited for up to DAEMON_REPLY_TIMEOUT.
+ * Past that, the reply port is handed over as an orphan (PA_IGNORE, no
+ * signal), reaped by subscribeOrphansReap() when the events come back.
  */
-static inline BYTE parseArguments(void)
+static void subscribeStop(void)
 {
-    typedef STRPTR (*GetArgStrFunc)(void);
-    GetArgStrFunc GetArgStr = (GetArgStrFunc)((UBYTE *)DOSBase + 0x114);
-    STRPTR args = GetArgStr();
-    UBYTE *p = (UBYTE *)args;
-    int hi, lo;
-    UBYTE configByte;
+    SubscribePort *sp;
+    UBYTE i;
     
-    // Skip leading spaces
-    while (*p == ' ' || *p == '\t')
-    {
-        p++;
-    }
+    subscribeOrphansReap();
     
-    // No argument = toggle mode
-    if (*p == '\0' || *p == '\n')
+    if (!s_subscribePort) return;
+    
+    s_subscribeExclusive = 0;
+    subscribePost(SUBSCRIBE_CODE_CLOSED, 0);
+    for (i = 0; i < SUBSCRIBERS_MAX; i++)
     {
-        s_configByte = DEFAULT_CONFIG_BYTE;
-        return START_MODE_TOGGLE;
+        subscribeRemove(s_subscribers[i].port);
     }
     
-    // Test STOP case-insensitive
-    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='o' && (p[3]|32)=='p')
+    for (i = 0; s_subscribePort && i < DAEMON_REPLY_TIMEOUT * 10; i++)
     {
-        return START_MODE_STOP;
+        Delay(5);
+        subscribeReap();
     }
     
-    // Test START case-insensitive
-    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='a' && (p[3]|32)=='r' && (p[4]|32)=='t')
+    if (s_subscribePort)
     {
-        // Check if START is followed by nothing, space, or newline
-        if (p[5] == '\0' || p[5] == ' ' || p[5] == '\t' || p[5] == '\n')
+        sp = (SubscribePort *)s_subscribePort;
+        
+        // Replies that arrive meanwhile stay queued and are counted by the reaper
+        Forbid();
+        for (i = 0; i < SUBSCRIBERS_MAX; i++)
         {
-            // Store config byte for daemon to use
-            s_configByte = DEFAULT_CONFIG_BYTE;
-            return START_MODE_START;
+            sp->pool[i] = s_subscribers[i].pool;
+            sp->outstanding[i] = (UBYTE)(SUBSCRIBE_POOL_SIZE - s_subscribers[i].freeCount);
+            s_subscribers[i].pool = NULL;
         }
+        sp->port.mp_Flags = PA_IGNORE;
+        sp->port.mp_SigTask = NULL;
+        sp->port.mp_Node.ln_Name = SUBSCRIBE_ORPHAN_NAME;
+        AddPort(&sp->port);
+        Permit();
+        FreeSignal(sp->port.mp_SigBit);
+        
+        DebugLog("Subscribe: events not replied, pools handed to the next daemon");
+        s_subscribePort = NULL;
+        s_subscribeSignal = 0;
     }
+}
+
+/**
+ * Create the event reply port (SubscribePort).
+ * Built by hand because CreateMsgPort() can't allocate the larger struct.
+ * @return Port, NULL on failure
+ */
+static struct MsgPort *subscribePortCreate(void)
+{
+    SubscribePort *sp;
+    BYTE sigBit;
     
-    // Test STATUS case-insensitive (must come after START check)
-    if ((p[0]|32)=='s' && (p[1]|32)=='t' && (p[2]|32)=='a' && (p[3]|32)=='t' && (p[4]|32)=='u' && (p[5]|32)=='s')
+    sigBit = AllocSignal(-1);
+    if (sigBit == -1)
     {
-        return START_MODE_STATUS;
+        return NULL;
     }
     
-    // Test hex format: 0xBYTE
-    if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+    sp = (SubscribePort *)AllocMem(sizeof(SubscribePort), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!sp)
     {
-        hi = parseHexDigit(p[2]);
-        lo = parseHexDigit(p[3]);
-        
-        if (hi >= 0 && lo >= 0)
-        {
-            configByte = (UBYTE)((hi << 4) | lo);
-            
-#ifdef RELEASE
-            // Force debug bit to 0 in release builds
-            configByte &= ~CONFIG_DEBUG_MODE;
-#endif
-            
-            // Check STOP conditions: neither wheel nor buttons enabled (bits 0-1)
-            if ((configByte & CONFIG_FEATURES_MASK) == 0)
-            {
-                //PrintF("config 0x%02lx = STOP (wheel and buttons disabled)", (ULONG)configByte);
-                return START_MODE_STOP;
-            }
-            
-            // Store config byte for daemon to use
-            s_configByte = configByte;
-
-            return START_MODE_CONFIG;
-        }
+        FreeSignal(sigBit);
+        return NULL;
     }
     
-    // Unknown argument
-    PrintF(MSG_UNKNOWN_ARGUMENT, args);
-    return START_MODE_TOGGLE;
+    sp->port.mp_Node.ln_Type = NT_MSGPORT;
+    sp->port.mp_Flags = PA_SIGNAL;
+    sp->port.mp_SigBit = (UBYTE)sigBit;
+    sp->port.mp_SigTask = FindTask(NULL);
+    sp->port.mp_MsgList.lh_Head = (struct Node *)&sp->port.mp_MsgList.lh_Tail;
+    sp->port.mp_MsgList.lh_Tail = NULL;
+    sp->port.mp_MsgList.lh_TailPred = (struct Node *)&sp->port.mp_MsgList.lh_Head;
+    
+    return &sp->port;
 }
 
-
-//===========================================================================
-// Daemon process functions
-//===========================================================================
-
 /**
- * Daemon main function.
- * This function runs in a separate process.
+ * Free orphaned event pools whose events have all been replied, and
+ * orphan ports left with no pool (daemon start and exit).
  */
-static void daemon(void)
+static void subscribeOrphansReap(void)
 {
-    ULONG timerSig, portSig, signals;
-    struct XMouseMsg *msg;
-    BOOL quit = FALSE;
-  
-    if (daemon_Init()) 
+    struct Node *node, *next;
+    struct XMouseEvent *ev;
+    SubscribePort *sp;
+    BOOL inUse;
+    UBYTE i, freed = 0;
+    
+    Forbid();
+    for (node = FindName(&SysBase->PortList, SUBSCRIBE_ORPHAN_NAME); node; node = next)
     {
-#ifndef RELEASE
-        // Open debug console if debug mode enabled
-        if (s_configByte & CONFIG_DEBUG_MODE)
-        {
-            s_debugCon = Open("CON:0/0/640/200/"PROGRAM_NAME" Debug/AUTO/CLOSE", MODE_NEWFILE);
-            
-            DebugLog("daemon started");
-            DebugLogF("Mode: %s", getModeName(s_configByte));
-            
-            if (s_configByte & CONFIG_FIXED_MODE)
-            {
-                DebugLogF("Poll: %ldms (normal)", (LONG)(s_pollInterval / 1000));
-            }
-            else
-            {
-                DebugLogF("Poll: %ld->%ld->%ldms (adaptive)", 
-                          (LONG)(s_activeMode->idleUs / 1000),
-                          (LONG)(s_activeMode->activeUs / 1000),
-                          (LONG)(s_activeMode->burstUs / 1000));
-            }
-            
-            DebugLog("---");
-        }
-#endif        
-        daemon_TimerStart(s_pollInterval);
-        
-        timerSig = 1L << s_TimerPort->mp_SigBit;
-        portSig = 1L << s_PublicPort->mp_SigBit;
+        // FindName() on a node searches from the next one
+        next = FindName((struct List *)node, SUBSCRIBE_ORPHAN_NAME);
+        sp = (SubscribePort *)node;
         
-        for (;;)
+        while ((ev = (struct XMouseEvent *)GetMsg(&sp->port)))
         {
-            // Wait for CTRL-C, timer signal, or messages
-            signals = Wait(SIGBREAKF_CTRL_C | timerSig | portSig);
-
-            if (signals & SIGBREAKF_CTRL_C)
-            {
-                break;
-            }
-            
-            // Process messages from public port
-            if (signals & portSig)
+            for (i = 0; i < SUBSCRIBERS_MAX; i++)
             {
-                while ((msg = (struct XMouseMsg *)GetMsg(s_PublicPort)))
-                {
-                    switch (msg->command)
-                    {
-                        case XMSG_CMD_QUIT:
-                            quit = TRUE;
-                            msg->result = 0;  // Success
-                            break;
-                            
-                        case XMSG_CMD_SET_CONFIG:
-                            {
-                                UBYTE oldConfig = s_configByte;
-                                UBYTE newConfig = (UBYTE)msg->value;
-                                UBYTE oldInterval = (oldConfig & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT;
-                                UBYTE newInterval = (newConfig & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT;
-                                
-#ifdef RELEASE
-                                // Force debug bit to 0 in release builds
-                                newConfig &= ~CONFIG_DEBUG_MODE;
-#endif
-                                
-                                s_configByte = newConfig;
-                                msg->result = 0;  // Success
-                                
-                                DebugLogF("Config changed: 0x%02lx -> 0x%02lx", (ULONG)oldConfig, (ULONG)newConfig);
-                                
-                                // If mode changed, reinitialize adaptive system
-                                if (oldInterval != newInterval || 
-                                    ((oldConfig ^ newConfig) & CONFIG_FIXED_MODE))
-                                {
-                                    UBYTE modeIndex = (newConfig & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT;
-                                                                        
-                                    s_activeMode = &s_adaptiveModes[modeIndex % 4];
-                                    
-                                    // Reinitialize based on new mode
-                                    if (newConfig & CONFIG_FIXED_MODE)
-                                    {
-                                        // Normal mode: use burstUs
-                                        s_adaptiveInterval = s_activeMode->burstUs;
-                                        s_pollInterval = s_activeMode->burstUs;
-                                        DebugLogF("Mode changed: %s (fixed %ldms)", s_activeMode->normalName, (LONG)(s_pollInterval / 1000));
-                                    }
-                                    else
-                                    {
-                                        // Adaptive mode: start from idle
-                                        s_adaptiveState = POLL_STATE_IDLE;
-                                        s_adaptiveInterval = s_activeMode->idleUs;
-                                        s_pollInterval = s_activeMode->idleUs;
-                                        DebugLogF("Mode changed: %s (adaptive)", s_activeMode->adaptiveName);
-                                    }
-                                    
-                                    s_adaptiveInactive = 0;
-                                    
-                                    // Restart timer with new interval
-                                    AbortIO((struct IORequest *)s_TimerReq);
-                                    WaitIO((struct IORequest *)s_TimerReq);
-                                    daemon_TimerStart(s_pollInterval);
-                                }
-                                
-#ifndef RELEASE
-                                // Handle debug mode change
-                                if ((oldConfig & CONFIG_DEBUG_MODE) && !(newConfig & CONFIG_DEBUG_MODE))
-                                {                                    // Debug mode disabled - close console
-                                    if (s_debugCon)
-                                    {
-                                        Close(s_debugCon);
-                                        s_debugCon = 0;
-                                    }
-                                }
-                                else if (!(oldConfig & CONFIG_DEBUG_MODE) && (newConfig & CONFIG_DEBUG_MODE))
-                                {
-                                    // Debug mode enabled - open console
-                                    if (!s_debugCon)
-                                    {
-                                        s_debugCon = Open("CON:0/0/640/200/"PROGRAM_NAME" Debug/AUTO/CLOSE", MODE_NEWFILE);
-                                        DebugLog("Debug mode enabled");
-                                    }
-                                }
-#endif
-                            }
-                            break;
-                            
-                        case XMSG_CMD_GET_STATUS:
-                            // Return config byte only
-                            DebugLogF("Status requested: config=0x%02lx", (ULONG)s_configByte);
-                            msg->result = (ULONG)s_configByte;
-                            break;
-                            
-                        default:
-                            msg->result = 0xFFFFFFFF;  // Error
-                            break;
-                    }
-                    
-                    ReplyMsg((struct Message *)msg);
-                }
-                
-                if (quit)
+                if (sp->pool[i] && ev >= sp->pool[i] && ev < sp->pool[i] + SUBSCRIBE_POOL_SIZE)
                 {
+                    sp->outstanding[i]--;
                     break;
                 }
             }
+        }
         
-            // Timer signal: poll & inject events
-            if (signals & timerSig)
+        inUse = FALSE;
+        for (i = 0; i < SUBSCRIBERS_MAX; i++)
+        {
+            if (sp->pool[i] && !sp->outstanding[i])
             {
-                BOOL hadActivity, hadWHActivity, hadBTActivity;
-                UWORD currentBTState;
-                //BYTE currentWHDir;
-                BYTE currentWHCounter;
-                int currentWHDelta;
-
-                // Prepare wheel delta if WH enabled
-                if (s_configByte & CONFIG_WHEEL_ENABLED)
-                {
-                    currentWHCounter = SAGA_WHEELCOUNTER;
-
-                    if (s_lastWHCounter != currentWHCounter)
-                    {
-                        // Calculate delta with wrap-around handling
-                        currentWHDelta = (int)(unsigned char)currentWHCounter - (int)(unsigned char)s_lastWHCounter;
-                        if (currentWHDelta != 0)
-                        {
-                            if (currentWHDelta > 127)
-                            {
-                                currentWHDelta -= 256;
-                            }
-                            else if (currentWHDelta < -128) 
-                            { 
-                                currentWHDelta += 256;
-                            }
-                        }
-                        hadWHActivity = TRUE;
-                    }
-                    else
-                    {
-                        hadWHActivity = s_lastWHDelta != 0;
-                        currentWHDelta = 0;
-                    }
-
-                    // currentWHDir = (currentWHDelta == 0 ? 0 : (currentWHDelta > 0) ? 1 : -1);
-                }
+                FreeMem(sp->pool[i], SUBSCRIBE_POOL_SIZE * sizeof(struct XMouseEvent));
+                sp->pool[i] = NULL;
+            }
+            inUse |= (sp->pool[i] != NULL);
+        }
+        
+        if (!inUse)
+        {
+            RemPort(&sp->port);
+            FreeMem(sp, sizeof(SubscribePort));
+            freed++;
+        }
+    }
+    Permit();
+    
+    if (freed)
+    {
+        DebugLogF("Subscribe: %ld orphaned port(s) freed", (LONG)freed);
+    }
+}
 
-                // get currentButtons
-                if (s_configByte & CONFIG_BUTTONS_ENABLED) {
-                    currentBTState = SAGA_MOUSE_BUTTONS & (SAGA_BUTTON4_MASK | SAGA_BUTTON5_MASK);
-                    
-                    // button has activity when state change or any button is pressed
-                    hadBTActivity = (currentBTState != s_lastBTState) || (currentBTState != 0);
-                }
+/**
+ * Pre-warm input handler: signal the daemon on the first pointer or
+ * button 1-3 event while the gate is armed. Events pass unchanged.
+ * @param events Input event chain
+ * @param gate Gate (is_Data)
+ * @return Unchanged event chain
+ */
+static struct InputEvent * __saveds prewarmHandler(__reg("a0") struct InputEvent *events, __reg("a1") PrewarmGate *gate)
+{
+    struct InputEvent *ie;
+    
+    if (!gate->armed) return events;
+    
+    for (ie = events; ie; ie = ie->ie_NextEvent)
+    {
+        if (ie->ie_Class == IECLASS_RAWMOUSE)
+        {
+            gate->armed = 0;
+            Signal(gate->task, gate->signal);
+            break;
+        }
+    }
+    return events;
+}
 
-                // determine if ther is an activity
-                hadActivity = hadWHActivity || hadBTActivity;
+/**
+ * Install the pre-warm input handler (gate disarmed until the next wakeup).
+ * On failure the option is cleared.
+ * @return TRUE on success
+ */
+static BOOL daemon_PrewarmStart(void)
+{
+    PrewarmGate *gate = &s_prewarmGate;
+    
+    if (s_prewarmSignal) return TRUE;
+    
+    s_prewarmSigBit = AllocSignal(-1);
+    if (s_prewarmSigBit < 0)
+    {
+        s_options &= ~OPT_PREWARM;
+        DebugLog("Pre-warm: no free signal");
+        return FALSE;
+    }
+    
+    s_prewarmReq = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
+    if (!s_prewarmReq)
+    {
+        FreeSignal(s_prewarmSigBit);
+        s_prewarmSigBit = -1;
+        s_options &= ~OPT_PREWARM;
+        return FALSE;
+    }
+    s_prewarmReq->io_Device = s_InputReq->io_Device;
+    s_prewarmReq->io_Unit = s_InputReq->io_Unit;
+    
+    gate->armed = 0;
+    gate->task = FindTask(NULL);
+    gate->signal = 1L << s_prewarmSigBit;
+    
+    s_prewarmInterrupt.is_Node.ln_Type = NT_INTERRUPT;
+    s_prewarmInterrupt.is_Node.ln_Pri = PREWARM_HANDLER_PRI;
+    s_prewarmInterrupt.is_Node.ln_Name = DAEMON_DESC_SHORT;
+    s_prewarmInterrupt.is_Data = (APTR)gate;
+    s_prewarmInterrupt.is_Code = (void (*)())prewarmHandler;
+    
+    s_prewarmReq->io_Command = IND_ADDHANDLER;
+    s_prewarmReq->io_Data = (APTR)&s_prewarmInterrupt;
+    DoIO((struct IORequest *)s_prewarmReq);
+    
+    s_prewarmSignal = gate->signal;
+    
+    DebugLog("Pre-warm: input handler installed");
+    return TRUE;
+}
 
-                if (hadActivity) 
-                {
-                    // Initialize event buffer (reused by both wheel and button processing)
-                    s_eventBuf.ie_NextEvent = NULL;
-                    s_eventBuf.ie_SubClass = 0;
-                    s_eventBuf.ie_Qualifier = PeekQualifier();  // Capture current qualifier state
-                    s_eventBuf.ie_X = 0;
-                    s_eventBuf.ie_Y = 0;
-                    s_eventBuf.ie_TimeStamp.tv_secs = 0;
-                    s_eventBuf.ie_TimeStamp.tv_micro = 0;
-                
-                    // Check for wheel activity
-                    if (hadWHActivity)
-                    {
-                        daemon_ProcessWheel(currentWHDelta);
-                    }
+/**
+ * Remove the pre-warm input handler and release its resources.
+ */
+static void daemon_PrewarmStop(void)
+{
+    if (!s_prewarmSignal) return;
+    
+    s_prewarmGate.armed = 0;
+    s_prewarmReq->io_Command = IND_REMHANDLER;
+    s_prewarmReq->io_Data = (APTR)&s_prewarmInterrupt;
+    DoIO((struct IORequest *)s_prewarmReq);
+    
+    DeleteIORequest((struct IORequest *)s_prewarmReq);
+    s_prewarmReq = NULL;
+    FreeSignal(s_prewarmSigBit);
+    s_prewarmSigBit = -1;
+    s_prewarmSignal = 0;
+    
+    DebugLog("Pre-warm: input handler removed");
+}
 
-                    // Check for button activity
-                    if (hadBTActivity)
-                    {
-                        daemon_ProcessButtons(currentBTState);
-                    }
-                }
+/**
+ * Mouse moved while idle: enter ACTIVE at activeUs now instead of
+ * waiting out the idle interval. Both engines restart from the top
+ * of the descent, as on a first wheel/button event.
+ */
+static void daemon_Prewarm(void)
+{
+    const AdaptiveMode *mode = s_activeMode;
+    
+    if (s_adaptiveState != POLL_STATE_IDLE || (s_configByte & CONFIG_FIXED_MODE) || SAMPLING_EVENT_DRIVEN())
+    {
+        return;
+    }
+    
+    s_adaptiveState = POLL_STATE_ACTIVE;
+    s_adaptiveStep = 0;
+    s_adaptiveInactive = 0;
+    if (s_ladderDec[0].us != mode->activeUs)
+    {
+        daemon_LadderFill(s_ladderDec, &s_ladderDecLast, mode->activeUs, mode->burstUs, mode->stepDecUs);
+    }
+    s_adaptiveInterval = s_ladderDec[0].us;
+    s_timerTicksUs = s_ladderDec[0].us;
+    s_timerTicks = s_ladderDec[0].ticks;
+    s_predictGap = mode->activeUs;
+    s_predictDev = mode->activeUs >> 1;
+    s_predictElapsed = 0;
+    s_pollInterval = s_adaptiveInterval;
+    
+    // Replace the pending idle request (drop its signal if it just completed)
+    AbortIO((struct IORequest *)s_TimerReq);
+    WaitIO((struct IORequest *)s_TimerReq);
+    SetSignal(0, 1L << s_TimerPort->mp_SigBit);
+    daemon_TimerStart(s_pollInterval);
+    
+    DebugLogF("Pre-warm: [IDLE->ACTIVE] interval=%ldus", (LONG)s_pollInterval);
+}
 
-                // Update adaptive interval and restart timer
-                if (s_configByte & CONFIG_FIXED_MODE)
-                {
-                    // Fixed mode: constant interval, direct restart
-                    daemon_TimerStart(s_pollInterval);
-                }
-                else
-                {
-                    // Adaptive mode: update interval and restart
-                    // No need for AbortIO/WaitIO here - timer already completed (we got the signal)
-                    s_pollInterval = daemon_GetAdaptiveInterval(hadActivity);
-                    daemon_TimerStart(s_pollInterval);
-                }
-                
-#ifndef RELEASE
-                if (s_configByte & CONFIG_DEBUG_MODE)
-                {
-                    s_pollCount++;
-                    
-                    // Log every 1000 timer polls (e.g., every 10 seconds at 10ms interval)
-                    //if (s_pollCount % 1000 == 0)
-                    //{
-                    //    DebugLogF("Timer polls: %lu (interval: %ldms)", s_pollCount, (LONG)(s_pollInterval / 1000));
-                    //}
-                }
-#endif
+/**
+ * Open the smoothing timer (MICROHZ, own port).
+ * On failure the option is cleared and detents are sent at once.
+ * @return TRUE on success
+ */
+static BOOL daemon_SmoothStart(void)
+{
+    if (s_smoothSignal) return TRUE;
+    
+    s_smoothPort = CreateMsgPort();
+    if (s_smoothPort)
+    {
+        s_smoothReq = (struct timerequest *)CreateIORequest(s_smoothPort, sizeof(struct timerequest));
+        if (s_smoothReq && !OpenDevice(TIMERNAME, UNIT_MICROHZ, (struct IORequest *)s_smoothReq, 0))
+        {
+            s_smoothReq->tr_node.io_Command = TR_ADDREQUEST;
+            s_smoothSignal = 1L << s_smoothPort->mp_SigBit;
+            s_smoothBusy = FALSE;
+            s_smoothPending = 0;
+            
+            DebugLog("Smoothing: on");
+            return TRUE;
+        }
+    }
+    
+    if (s_smoothReq)
+    {
+        DeleteIORequest((struct IORequest *)s_smoothReq);
+        s_smoothReq = NULL;
+    }
+    if (s_smoothPort)
+    {
+        DeleteMsgPort(s_smoothPort);
+        s_smoothPort = NULL;
+    }
+    s_options &= ~OPT_WHEEL_SMOOTH;
+    DebugLog("Smoothing: no timer");
+    return FALSE;
+}
 
-                // Update last values
-                s_lastWHCounter = currentWHCounter;
-                s_lastWHDelta   = currentWHDelta;
-                //s_lastWHDir     = currentWHDir;
-                s_lastBTState   = currentBTState;
-            }
-        }
+/**
+ * Close the smoothing timer. Pending detents are injected at once.
+ */
+static void daemon_SmoothStop(void)
+{
+    if (!s_smoothSignal) return;
+    
+    if (s_smoothBusy)
+    {
+        AbortIO((struct IORequest *)s_smoothReq);
+        WaitIO((struct IORequest *)s_smoothReq);
+        s_smoothBusy = FALSE;
     }
+    s_smoothSignal = 0;
+    
+    if (s_smoothPending)
+    {
+        injectBegin();
+        injectWheel(s_smoothPending);
+        injectFlush();
+        s_smoothPending = 0;
+    }
+    
+    CloseDevice((struct IORequest *)s_smoothReq);
+    DeleteIORequest((struct IORequest *)s_smoothReq);
+    s_smoothReq = NULL;
+    DeleteMsgPort(s_smoothPort);
+    s_smoothPort = NULL;
+    
+    DebugLog("Smoothing: off");
+}
 
-    daemon_Cleanup();
+/**
+ * Take a wheel delta for smoothing (tick context, chain begun).
+ * The first detent joins the current chain, the others wait for
+ * daemon_SmoothArm(). On a reversal the detents left from the last spin
+ * are injected at once, before the new direction starts.
+ * @param delta Signed wheel delta (after acceleration)
+ * @return TRUE if taken, FALSE to inject it as usual (single detent)
+ */
+static BOOL daemon_SmoothWheel(int delta)
+{
+    int step = (delta > 0) ? 1 : -1;
+    
+    if (s_smoothPending && (s_smoothPending > 0) != (delta > 0))
+    {
+        injectWheel(s_smoothPending);
+        s_smoothPending = 0;
+    }
+    
+    if (!s_smoothPending)
+    {
+        if (delta == step)
+        {
+            return FALSE;
+        }
+        injectWheel(step);
+        delta -= step;
+    }
+    
+    s_smoothPending += delta;
+    s_smoothRestart = TRUE;
+    return TRUE;
 }
 
 /**
- * Start the timer with the specified timeout in microseconds.
- * @param micros Timeout in microseconds.
+ * Schedule the next pending detent. Called at the end of a wakeup, so
+ * the poll interval chosen by the tick is known. A new window of N
+ * pending detents gives them the slots W/(N+1) .. W*N/(N+1): the next
+ * tick's detents don't pile up on the last one.
  */
-static inline void daemon_TimerStart(ULONG micros)
+static void daemon_SmoothArm(void)
 {
-    s_TimerReq->tr_node.io_Command = TR_ADDREQUEST;
-    s_TimerReq->tr_time.tv_secs = micros / 1000000;
-    s_TimerReq->tr_time.tv_micro = micros % 1000000;
-    SendIO((struct IORequest *)s_TimerReq);
+    ULONG count = (ULONG)((s_smoothPending > 0) ? s_smoothPending : -s_smoothPending);
+    UBYTE frames = (UBYTE)((s_options & OPT_SMOOTH_FRAMES_MASK) >> OPT_SMOOTH_FRAMES_SHIFT);
+    ULONG window, slot;
+    
+    if (s_smoothRestart)
+    {
+        // Interrupt sampling has no poll interval: one frame
+        if (!frames && !SAMPLING_EVENT_DRIVEN())
+        {
+            window = s_pollInterval;
+        }
+        else
+        {
+            window = (frames ? frames : 1) * (1000000 / SysBase->VBlankFrequency);
+        }
+        s_smoothLeftUs = window - window / (count + 1);
+        s_smoothRestart = FALSE;
+    }
+    
+    slot = s_smoothLeftUs / count;
+    if (slot < SMOOTH_SLOT_MIN_US)
+    {
+        slot = SMOOTH_SLOT_MIN_US;
+    }
+    s_smoothLeftUs = (s_smoothLeftUs > slot) ? s_smoothLeftUs - slot : 0;
+    
+    s_smoothReq->tr_time.tv_secs = slot / 1000000;
+    s_smoothReq->tr_time.tv_micro = slot % 1000000;
+    SendIO((struct IORequest *)s_smoothReq);
+    s_smoothBusy = TRUE;
 }
 
 /**
- * Inject input event to input.device.
- * Reuses caller's InputEvent struct to avoid repeated allocations.
- * @param ev Pre-filled InputEvent struct
+ * Smoothing timer fired: inject the next pending detent.
  */
-static inline void injectEvent(struct InputEvent *ev)
+static void daemon_SmoothTick(void)
 {
-    //DebugLogF("  injectEvent: class=0x%02lx code=0x%02lx qualifier=0x%04lx", 
-    //          (ULONG)ev->ie_Class, (ULONG)ev->ie_Code, (ULONG)ev->ie_Qualifier);
+    int step;
     
-    s_InputReq->io_Command = IND_WRITEEVENT;
-    s_InputReq->io_Data = (APTR)ev;
-    s_InputReq->io_Length = sizeof(struct InputEvent);
+    if (!GetMsg(s_smoothPort)) return;
+    s_smoothBusy = FALSE;
     
-    DoIO((struct IORequest *)s_InputReq);
+    if (!s_smoothPending) return;
+    
+    step = (s_smoothPending > 0) ? 1 : -1;
+    injectBegin();
+    injectWheel(step);
+    injectFlush();
+    s_smoothPending -= step;
 }
 
 /**
- * Process wheel movement and inject events if needed.
- * Reuses s_eventBuf (only ie_Code and ie_Class are modified).
- * @param delta Current wheel delta
+ * Injection handler: link queued chains, oldest first, in front of the
+ * events input.device is processing.
+ * @param events Input event chain
+ * @param q Handler queue (is_Data)
+ * @return Queued chains followed by the original events
  */
-static inline void daemon_ProcessWheel(int delta)
+static struct InputEvent * __saveds injectHandler(__reg("a0") struct InputEvent *events, __reg("a1") HandlerQueue *q)
 {
-    if (delta == 0) return;
+    UBYTE tail = q->tail;
+    UBYTE head = q->head;
+    struct InputEvent *first;
+    struct EClockVal now;
+    
+    if (tail == head) return events;
+    
+    ReadEClock(&now);
+    first = q->first[tail];
+    while (tail != head)
+    {
+        UBYTE next = (tail + 1) & (HANDLER_QUEUE_SIZE - 1);
         
-    // Determine direction and repeat count
-    UWORD code = (delta > 0) ? NM_WHEEL_UP : NM_WHEEL_DOWN;
-    int count = ((delta > 0) ? delta : -delta);
+        q->last[tail]->ie_NextEvent = (next != head) ? q->first[next] : events;
+        q->spliceClock[tail] = now.ev_lo;
+        tail = next;
+    }
+    q->tail = tail;
     
-    DebugLogF("Wheel: %s delta=%ld", (delta > 0) ? "UP" : "DOWN", (LONG)delta);
+    return first;
+}
+
+/**
+ * Install the injection handler and create the kick request.
+ * On failure the option is cleared (IND_WRITEEVENT injection kept).
+ * @return TRUE on success
+ */
+static BOOL injectHandlerStart(void)
+{
+    HandlerQueue *q = &s_handlerQueue;
     
-    // Reuse s_eventBuf (only ie_Code and ie_Class change)
-    s_eventBuf.ie_Code = code;
+    if (s_handlerReq) return TRUE;
     
-    // Repeat events based on delta
-    for (int i = 0; i < count; i++)
+    s_handlerReq = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
+    s_kickReq = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
+    if (!s_handlerReq || !s_kickReq)
     {
-        // Inject both RAWKEY - Modern apps
-        s_eventBuf.ie_Class = IECLASS_RAWKEY;
-        injectEvent(&s_eventBuf);
-        
-        // and NEWMOUSE - Legacy apps
-        s_eventBuf.ie_Class = IECLASS_NEWMOUSE;
-        injectEvent(&s_eventBuf);
+        if (s_handlerReq) DeleteIORequest((struct IORequest *)s_handlerReq);
+        if (s_kickReq) DeleteIORequest((struct IORequest *)s_kickReq);
+        s_handlerReq = NULL;
+        s_kickReq = NULL;
+        s_options &= ~OPT_HANDLER_INJECT;
+        DebugLog("Handler injection: no memory");
+        return FALSE;
     }
+    s_handlerReq->io_Device = s_kickReq->io_Device = s_InputReq->io_Device;
+    s_handlerReq->io_Unit = s_kickReq->io_Unit = s_InputReq->io_Unit;
+    s_kickBusy = FALSE;
+    
+    q->head = 0;
+    q->tail = 0;
+    s_handlerReleased = 0;
+    s_kickHead = 0;
+    
+    s_injectInterrupt.is_Node.ln_Type = NT_INTERRUPT;
+    s_injectInterrupt.is_Node.ln_Pri = INJECT_HANDLER_PRI;
+    s_injectInterrupt.is_Node.ln_Name = DAEMON_DESC_SHORT;
+    s_injectInterrupt.is_Data = (APTR)q;
+    s_injectInterrupt.is_Code = (void (*)())injectHandler;
+    
+    s_handlerReq->io_Command = IND_ADDHANDLER;
+    s_handlerReq->io_Data = (APTR)&s_injectInterrupt;
+    DoIO((struct IORequest *)s_handlerReq);
+    
+    DebugLog("Injection: input handler");
+    return TRUE;
+}
 
-    // Log wheel event
-    //DebugLogF("Wheel: delta=%ld dir=%s count=%ld", 
-    //         (LONG)delta, 
-    //         (code == NM_WHEEL_UP) ? "UP" : "DOWN", 
-    //         (LONG)count);
+/**
+ * Splice what is still queued, remove the handler, free the requests.
+ */
+static void injectHandlerStop(void)
+{
+    if (!s_handlerReq) return;
+    
+    injectDrain();
+    
+    s_handlerReq->io_Command = IND_REMHANDLER;
+    s_handlerReq->io_Data = (APTR)&s_injectInterrupt;
+    DoIO((struct IORequest *)s_handlerReq);
+    
+    DeleteIORequest((struct IORequest *)s_handlerReq);
+    DeleteIORequest((struct IORequest *)s_kickReq);
+    s_handlerReq = NULL;
+    s_kickReq = NULL;
+    
+    DebugLog("Injection: IND_WRITEEVENT");
 }
 
 /**
- * Process buttons and inject events if needed.
- * Reuses s_eventBuf (only ie_Code and ie_Class are modified).
- * @param state Current button state (already read and masked from SAGA_MOUSE_BUTTONS)
+ * Send the IECLASS_NULL kick event (no wait): input.device runs the
+ * handler chain, which splices everything queued so far. The queue head
+ * is recorded: its reply covers the entries before it.
  */
-static inline void daemon_ProcessButtons(UWORD state)
+static void injectKick(void)
 {
-    UWORD changed;
-    UWORD code;
+    s_kickHead = s_handlerQueue.head;
+
+    s_kickEvent.ie_NextEvent = NULL;
+    s_kickEvent.ie_Class = IECLASS_NULL;
+    s_kickEvent.ie_SubClass = 0;
+    s_kickEvent.ie_Code = 0;
+    s_kickEvent.ie_Qualifier = 0;
+    s_kickEvent.ie_X = 0;
+    s_kickEvent.ie_Y = 0;
     
-    // Use provided current value (already read and masked in main loop)
-    changed = state ^ s_lastBTState;
+    s_kickReq->io_Command = IND_WRITEEVENT;
+    s_kickReq->io_Data = (APTR)&s_kickEvent;
+    s_kickReq->io_Length = sizeof(struct InputEvent);
+    SendIO((struct IORequest *)s_kickReq);
+    s_kickBusy = TRUE;
+}
+
+/**
+ * Release the slots of chains queued before the last kick, once it is
+ * replied: input.device is done with them. Spliced is not enough, the
+ * handlers after ours may still be reading the events.
+ */
+static void injectHandlerRelease(void)
+{
+    if (s_kickBusy) return;
     
-    if (changed)
+    while (s_handlerReleased != s_kickHead)
     {
-        if (changed & SAGA_BUTTON4_MASK)
+        if (s_handlerSlots[s_handlerReleased])
         {
-            code = NM_BUTTON_FOURTH | ((state & SAGA_BUTTON4_MASK) ? 0 : IECODE_UP_PREFIX);
+            s_handlerSlots[s_handlerReleased]->busy = FALSE;
+            s_handlerSlots[s_handlerReleased] = NULL;
+        }
+        s_handlerReleased = (s_handlerReleased + 1) & (HANDLER_QUEUE_SIZE - 1);
+    }
+}
+
+/**
+ * Injection latency benchmark: LATENCY_ROUNDS IECLASS_NULL events
+ * through IND_WRITEEVENT (DoIO) and through the handler queue.
+ * The handler is installed for the run if the option is off.
+ * @param lat Result buffer, 'size' set by the sender
+ * @return LATENCY_VERSION, 0xFFFFFFFF on error
+ */
+static ULONG daemon_BenchLatency(struct XMouseLatency *lat)
+{
+    static struct InputEvent event;
+    struct XMouseLatency result;
+    struct EClockVal start, end;
+    ULONG total[LATENCY_PATH_COUNT];
+    ULONG elapsed;
+    BOOL installed = FALSE;
+    UWORD size;
+    UBYTE path, head;
+    UWORD r;
+    
+    if (!lat || lat->size < 2 * sizeof(UWORD))
+    {
+        return 0xFFFFFFFF;
+    }
+    
+    // Sync paths below reuse slot 0 and the kick request
+    injectDrain();
+    if (!s_handlerReq)
+    {
+        if (!injectHandlerStart()) return 0xFFFFFFFF;
+        installed = TRUE;
+    }
+    
+    for (path = 0; path < LATENCY_PATH_COUNT; path++)
+    {
+        result.min[path] = 0xFFFFFFFF;
+        result.max[path] = 0;
+        total[path] = 0;
+    }
+    
+    for (r = 0; r < LATENCY_ROUNDS; r++)
+    {
+        event.ie_NextEvent = NULL;
+        event.ie_Class = IECLASS_NULL;
+        event.ie_SubClass = 0;
+        event.ie_Code = 0;
+        event.ie_Qualifier = 0;
+        event.ie_X = 0;
+        event.ie_Y = 0;
         
-            DebugLogF("Button 4: %s", (state & SAGA_BUTTON4_MASK) ? "PRESS" : "RELEASE");
+        // IND_WRITEEVENT: submit to reply
+        s_InputReq->io_Command = IND_WRITEEVENT;
+        s_InputReq->io_Data = (APTR)&event;
+        s_InputReq->io_Length = sizeof(struct InputEvent);
+        ReadEClock(&start);
+        DoIO((struct IORequest *)s_InputReq);
+        ReadEClock(&end);
+        elapsed = end.ev_lo - start.ev_lo;
+        total[LATENCY_PATH_DOIO] += elapsed;
+        if (elapsed < result.min[LATENCY_PATH_DOIO]) result.min[LATENCY_PATH_DOIO] = elapsed;
+        if (elapsed > result.max[LATENCY_PATH_DOIO]) result.max[LATENCY_PATH_DOIO] = elapsed;
+        
+        // Handler: queue (no owning slot), kick, wait for the kick reply
+        event.ie_NextEvent = NULL;
+        head = s_handlerQueue.head;
+        s_handlerSlots[head] = NULL;
+        s_handlerQueue.first[head] = &event;
+        s_handlerQueue.last[head] = &event;
+        ReadEClock(&start);
+        s_handlerQueue.head = (head + 1) & (HANDLER_QUEUE_SIZE - 1);
+        injectKick();
+        WaitIO((struct IORequest *)s_kickReq);
+        ReadEClock(&end);
+        s_kickBusy = FALSE;
+        injectHandlerRelease();
+        
+        elapsed = s_handlerQueue.spliceClock[head] - start.ev_lo;
+        total[LATENCY_PATH_SPLICE] += elapsed;
+        if (elapsed < result.min[LATENCY_PATH_SPLICE]) result.min[LATENCY_PATH_SPLICE] = elapsed;
+        if (elapsed > result.max[LATENCY_PATH_SPLICE]) result.max[LATENCY_PATH_SPLICE] = elapsed;
+        
+        elapsed = end.ev_lo - start.ev_lo;
+        total[LATENCY_PATH_KICK] += elapsed;
+        if (elapsed < result.min[LATENCY_PATH_KICK]) result.min[LATENCY_PATH_KICK] = elapsed;
+        if (elapsed > result.max[LATENCY_PATH_KICK]) result.max[LATENCY_PATH_KICK] = elapsed;
+    }
+    
+    if (installed)
+    {
+        injectHandlerStop();
+    }
+    
+    for (path = 0; path < LATENCY_PATH_COUNT; path++)
+    {
+        result.mean[path] = total[path] / LATENCY_ROUNDS;
+    }
+    result.version = LATENCY_VERSION;
+    result.eclockFreq = s_eclockFreq;
+    result.rounds = LATENCY_ROUNDS;
+    
+    size = (lat->size < sizeof(result)) ? lat->size : sizeof(result);
+    result.size = size;
+    CopyMem(&result, lat, size);
+    
+    return LATENCY_VERSION;
+}
 
-            s_eventBuf.ie_Code = code;
-            
-            s_eventBuf.ie_Class = IECLASS_RAWKEY;
-            injectEvent(&s_eventBuf);
-            
-            s_eventBuf.ie_Class = IECLASS_NEWMOUSE;
-            injectEvent(&s_eventBuf);
+#endif // XMOUSED_HOST
+
+/**
+ * Process samples latched by the VBL server.
+ * Wheel deltas are summed, each button change is injected in order
+ * (after the wheel movement that preceded it). One chain per wakeup.
+ */
+static inline void daemon_VblTick(void)
+{
+    VblMailbox *mb = &s_vblMailbox;
+    UBYTE tail = mb->tail;
+    BOOL begun = FALSE;
+    int wheelDelta = 0;
+    struct EClockVal now;
+    ULONG clock;
+    
+    // Samples of one wakeup share its timestamp
+    HAL_ReadClock(&now);
+    clock = now.ev_lo;
+    s_shared.stats.ticks++;
+    
+    if (s_trace)
+    {
+        s_traceHeader.ticks++;
+    }
+    
+    while (tail != mb->head)
+    {
+        UWORD raw = mb->samples[tail];
+        MouseSample sample;
+        
+        tail = (tail + 1) & (VBL_MAILBOX_SIZE - 1);
+        mb->tail = tail;
+        
+        if (s_trace)
+        {
+            daemon_TraceSample(raw, clock);
         }
         
-        if (changed & SAGA_BUTTON5_MASK)
+        daemon_DecodeSample(raw, &sample);
+        if (s_configByte & CONFIG_WHEEL_ENABLED)
         {
-            code = NM_BUTTON_FIFTH | ((state & SAGA_BUTTON5_MASK) ? 0 : IECODE_UP_PREFIX);
-
-            DebugLogF("Button 5: %s", (state & SAGA_BUTTON5_MASK) ? "PRESS" : "RELEASE");
-
-            s_eventBuf.ie_Code = code;
-            
-            s_eventBuf.ie_Class = IECLASS_RAWKEY;
-            injectEvent(&s_eventBuf);
-            
-            s_eventBuf.ie_Class = IECLASS_NEWMOUSE;
-            injectEvent(&s_eventBuf);
+            wheelDelta += daemon_WheelDelta(sample.wheel);
+            s_lastWHCounter = sample.wheel;
+        }
+        
+        if ((s_configByte & CONFIG_BUTTONS_ENABLED) && sample.buttons != s_lastBTState)
+        {
+            if (!begun)
+            {
+                injectBegin();
+                begun = TRUE;
+            }
+            daemon_ProcessWheel(wheelDelta);
+            wheelDelta = 0;
+            daemon_ProcessButtons(sample.buttons);
+            s_lastBTState = sample.buttons;
+        }
+    }
+    
+    if (wheelDelta)
+    {
+        if (!begun)
+        {
+            injectBegin();
+            begun = TRUE;
         }
+        daemon_ProcessWheel(wheelDelta);
+    }
+    
+    if (begun)
+    {
+        injectFlush();
     }
+    
+    daemon_StatsTick(clock);
 }
 
 /**
- * Update adaptive polling interval based on activity.
- * State machine: IDLE → ACTIVE → BURST → TO_IDLE → IDLE
- * Only called in adaptive mode (bit 6 = 0). Normal mode bypasses this function.
- * @param hadActivity TRUE if wheel/button activity detected this tick
+ * Inject what the CIA interrupt latched since the last drain.
+ * Wheel movement up to each button change is injected before it,
+ * as in daemon_VblTick(). One chain per wakeup.
  */
-static inline ULONG daemon_GetAdaptiveInterval(BOOL hadActivity)
+static inline void daemon_CiaTick(void)
 {
-    const AdaptiveMode *mode = s_activeMode;
-    ULONG oldUs = s_adaptiveInterval;
-    UBYTE oldState = s_adaptiveState;
+    CiaSampler *cs = &s_ciaSampler;
+    UBYTE tail = cs->tail;
+    UBYTE counter = (UBYTE)s_lastWHCounter;
+    BOOL begun = FALSE;
+    ULONG total;
+    struct EClockVal now;
+    ULONG clock;
     
-    // Accumulate inactive time by adding current poll interval
-    if (hadActivity)
+    // Changes from now on signal again
+    cs->signalled = 0;
+    
+    HAL_ReadClock(&now);
+    clock = now.ev_lo;
+    s_shared.stats.ticks++;
+    
+    while (tail != cs->head)
     {
-        s_adaptiveInactive = 0;  // Reset accumulated inactive time
+        UWORD state = cs->edgeButtons[tail];
+        ULONG wheel = cs->edgeWheel[tail];
+        
+        tail = (tail + 1) & (CIA_EDGE_RING_SIZE - 1);
+        cs->tail = tail;
+        
+        if (!begun)
+        {
+            injectBegin();
+            begun = TRUE;
+        }
+        daemon_ProcessWheel((int)(LONG)(wheel - s_ciaWheelTaken));
+        counter += (UBYTE)(wheel - s_ciaWheelTaken);
+        s_ciaWheelTaken = wheel;
+        daemon_ProcessButtons(state);
+        s_lastBTState = state;
+        
+        if (s_trace)
+        {
+            // Each latched change, rebuilt as a register sample
+            daemon_TraceSample((state | counter) & cs->mask, clock);
+        }
     }
-    else
+    
+    total = cs->wheelTotal;
+    if (total != s_ciaWheelTaken)
     {
-        s_adaptiveInactive += s_adaptiveInterval;  // Add current interval to inactive time
+        if (!begun)
+        {
+            injectBegin();
+            begun = TRUE;
+        }
+        daemon_ProcessWheel((int)(LONG)(total - s_ciaWheelTaken));
+        s_ciaWheelTaken = total;
     }
+    s_lastWHCounter = (BYTE)cs->last;
     
-    // State machine
-    switch (s_adaptiveState)
+    if (begun)
     {
-        case POLL_STATE_IDLE:
-            if (hadActivity)
-            {
-                // Jump to ACTIVE
-                s_adaptiveState = POLL_STATE_ACTIVE;
-                s_adaptiveInterval = mode->activeUs;
-#ifdef DEBUG_ADAPTIVE
-                DebugLogF("[IDLE->ACTIVE] %ldus | InactiveUs=%ld", 
-                          (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-            }
-            break;
-            
-        case POLL_STATE_ACTIVE:
-            if (hadActivity)
-            {
-                // Descend toward BURST every tick with activity
-                if (s_adaptiveInterval > mode->burstUs)
-                {
-                    s_adaptiveInterval = (s_adaptiveInterval > mode->stepDecUs) ? (s_adaptiveInterval - mode->stepDecUs) : mode->burstUs;
-                }
-                
-                // Reached BURST floor?
-                if (s_adaptiveInterval <= mode->burstUs)
-                {
-                    s_adaptiveState = POLL_STATE_BURST;
-                    s_adaptiveInterval = mode->burstUs;
-#ifdef DEBUG_ADAPTIVE
-                    DebugLogF("[ACTIVE->BURST] %ldus | InactiveUs=%ld", 
-                              (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-                }
-            }
-            else
-            {
-                // Check accumulated inactivity in microseconds
-                if (s_adaptiveInactive >= mode->activeThreshold)
-                {
-                    s_adaptiveState = POLL_STATE_TO_IDLE;
-#ifdef DEBUG_ADAPTIVE
-                    DebugLogF("[ACTIVE->TO_IDLE] %ldus | InactiveUs=%ld", 
-                              (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-                }
-            }
-            break;
-            
-        case POLL_STATE_BURST:
-            if (!hadActivity)
-            {
-                // Check accumulated inactivity in microseconds
-                if (s_adaptiveInactive >= mode->idleThreshold)
-                {
-                    // Transition to TO_IDLE
-                    s_adaptiveState = POLL_STATE_TO_IDLE;
-#ifdef DEBUG_ADAPTIVE
-                    DebugLogF("[BURST->TO_IDLE] %ldus | InactiveUs=%ld", 
-                              (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-                }
-            }
-            break;
-            
-        case POLL_STATE_TO_IDLE:
-            if (hadActivity)
-            {
-                // Return to ACTIVE
-                if (s_adaptiveInterval > mode->activeUs)
-                {
-                    s_adaptiveInterval = mode->activeUs;
-                }
-                s_adaptiveState = POLL_STATE_ACTIVE;
-#ifdef DEBUG_ADAPTIVE
-                DebugLogF("[TO_IDLE->ACTIVE] %ldus | InactiveUs=%ld", 
-                          (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-            }
-            else
-            {
-                // Ascend toward IDLE every tick without activity
-                if (s_adaptiveInterval < mode->idleUs)
-                {
-                    s_adaptiveInterval += mode->stepIncUs;
-                    
-                    // Clamp to idleUs ceiling
-                    if (s_adaptiveInterval > mode->idleUs)
-                    {
-                        s_adaptiveInterval = mode->idleUs;
-                    }
-                }
-                
-                // Reached IDLE ceiling?
-                if (s_adaptiveInterval >= mode->idleUs)
-                {
-                    s_adaptiveState = POLL_STATE_IDLE;
-                    s_adaptiveInterval = mode->idleUs;
-#ifdef DEBUG_ADAPTIVE
-                    DebugLogF("[TO_IDLE->IDLE] %ldus | InactiveUs=%ld", 
-                              (LONG)s_adaptiveInterval, (LONG)s_adaptiveInactive);
-#endif
-                }
-            }
-            break;
+        injectFlush();
+    }
+    
+    if (s_trace)
+    {
+        s_traceHeader.ticks++;
+        daemon_TraceSample(cs->last, clock);
+    }
+    
+    daemon_StatsTick(clock);
+}
+
+/**
+ * Record a register sample if the watched bits changed.
+ * @param raw Register sample (watched bits)
+ * @param clock EClock (low 32 bits) of the sample
+ */
+static inline void daemon_TraceSample(UWORD raw, ULONG clock)
+{
+    if (raw == s_traceLast) return;
+    
+    s_traceLast = raw;
+    daemon_TraceRecord(TRACE_SAMPLE, raw, clock);
+}
+
+/**
+ * Append a record to the capture buffer (counted as dropped when full).
+ * @param type TRACE_* record type
+ * @param value Sample or event count
+ * @param clock EClock (low 32 bits)
+ */
+static inline void daemon_TraceRecord(UWORD type, UWORD value, ULONG clock)
+{
+    TraceRecord *rec;
+    
+    if (s_traceHeader.count >= TRACE_RECORDS_MAX)
+    {
+        s_traceHeader.dropped++;
+        return;
     }
     
+    rec = &s_trace[s_traceHeader.count++];
+    rec->clock = clock;
+    rec->value = value;
+    rec->type = type;
+}
+
+/**
+ * Record the changes stamped by the record-only VBL sampler.
+ * Called before the tick injects, so records stay in time order.
+ */
+static void daemon_TraceDrain(void)
+{
+    TraceSampler *ts = &s_traceSampler;
+    UBYTE tail = ts->tail;
+    
+    while (tail != ts->head)
+    {
+        daemon_TraceSample(ts->samples[tail], ts->clocks[tail]);
+        tail = (tail + 1) & (TRACE_RING_SIZE - 1);
+        ts->tail = tail;
+    }
+    if (ts->lost)
+    {
+        s_traceHeader.dropped += ts->lost;
+        ts->lost = 0;
+    }
+}
 
-#ifndef RELEASE
-    // Log state changes (even without interval change)
-    if (s_configByte & CONFIG_DEBUG_MODE)
+#ifndef XMOUSED_HOST
+/**
+ * Sampling source active now, for the trace header.
+ * @return TRACE_SOURCE_*
+ */
+static UWORD daemon_TraceSource(void)
+{
+    return s_ciaSignal ? TRACE_SOURCE_CIA :
+           ((s_vblSignal || s_traceSamplerOn) ? TRACE_SOURCE_VBL : TRACE_SOURCE_TIMER);
+}
+
+/**
+ * Record-only VBL server: stamps register changes, never signals.
+ * @param ts Sampler (is_Data)
+ * @return 0 (Z flag set, continue server chain)
+ */
+static ULONG __saveds traceServer(__reg("a1") TraceSampler *ts)
+{
+    UWORD raw = HAL_ReadRegister() & ts->mask;
+    
+    if (raw != ts->last)
     {
-        const char *stateNames[] = {"IDLE", "ACTIVE", "BURST", "TO_IDLE"};
+        UBYTE next = (ts->head + 1) & (TRACE_RING_SIZE - 1);
+        struct EClockVal clock;
         
-        // State changed?
-        if (oldState != s_adaptiveState)
+        ts->last = raw;
+        if (next != ts->tail)
+        {
+            HAL_ReadClock(&clock);
+            ts->samples[ts->head] = raw;
+            ts->clocks[ts->head] = clock.ev_lo;
+            ts->head = next;
+        }
+        else
         {
-            DebugLogF("Adaptive: [%s->%s] interval=%ldus", 
-                      stateNames[oldState], stateNames[s_adaptiveState], 
-                      (LONG)s_adaptiveInterval);
+            ts->lost++;
         }
     }
-#endif
+    return 0;
+}
 
-    return s_adaptiveInterval;
+/**
+ * Install the record-only VBL sampler while capturing with timer
+ * polling, remove it otherwise (VBL/CIA sampling record themselves).
+ * The poll path is not changed.
+ */
+static void daemon_TraceSamplerUpdate(void)
+{
+    TraceSampler *ts = &s_traceSampler;
+    BOOL want = s_trace && !SAMPLING_EVENT_DRIVEN();
+    
+    if (want == s_traceSamplerOn) return;
+    
+    if (!want)
+    {
+        daemon_TraceSamplerStop();
+    }
+    else
+    {
+        ts->mask = daemon_SampleMask();
+        ts->last = ((UWORD)s_lastBTState | (UBYTE)s_lastWHCounter) & ts->mask;
+        ts->head = 0;
+        ts->tail = 0;
+        ts->lost = 0;
+        
+        s_traceInterrupt.is_Node.ln_Type = NT_INTERRUPT;
+        s_traceInterrupt.is_Node.ln_Pri = VBL_SERVER_PRI;
+        s_traceInterrupt.is_Node.ln_Name = DAEMON_DESC_SHORT;
+        s_traceInterrupt.is_Data = (APTR)ts;
+        s_traceInterrupt.is_Code = (void (*)())traceServer;
+        AddIntServer(INTB_VERTB, &s_traceInterrupt);
+        s_traceSamplerOn = TRUE;
+        
+        // Current state first, the server only stamps changes
+        daemon_TraceSample(ts->last, s_timerFireClock);
+    }
+    
+    // A running capture keeps the coarsest source it was sampled with
+    if (daemon_TraceSource() < s_traceHeader.source)
+    {
+        s_traceHeader.source = daemon_TraceSource();
+    }
 }
 
 /**
- * Initialize daemon resources.
- * @return TRUE on success, FALSE on failure.
+ * Remove the record-only VBL sampler, recording what it stamped.
  */
-static inline BOOL daemon_Init(void)
+static void daemon_TraceSamplerStop(void)
 {
-    SysBase = *(struct ExecBase **)4L;
-    DOSBase = (struct DosLibrary *)OpenLibrary("dos.library", 36);
-    if (!DOSBase)
+    if (!s_traceSamplerOn) return;
+    
+    RemIntServer(INTB_VERTB, &s_traceInterrupt);
+    s_traceSamplerOn = FALSE;
+    daemon_TraceDrain();
+}
+
+/**
+ * Allocate the capture buffer and start recording.
+ * On allocation failure the option is cleared (capture off).
+ */
+static void daemon_TraceStart(void)
+{
+    if (s_trace) return;
+    
+    s_trace = (TraceRecord *)AllocMem(TRACE_RECORDS_MAX * sizeof(TraceRecord), MEMF_ANY);
+    if (!s_trace)
     {
-        return FALSE;
+        s_options &= ~OPT_TRACE_CAPTURE;
+        DebugLog("Trace: no memory");
+        return;
     }
+    
+    s_traceHeader.magic = TRACE_MAGIC;
+    s_traceHeader.version = TRACE_VERSION;
+    s_traceHeader.config = s_configByte;
+    s_traceHeader.timerUnit = s_timerUnit;
+    s_traceHeader.options = s_options;
+    s_traceHeader.eclockFreq = s_eclockFreq;
+    s_traceHeader.ticks = 0;
+    s_traceHeader.count = 0;
+    s_traceHeader.dropped = 0;
+    s_traceLast = 0xFFFF;  // First sample always recorded
+    daemon_TraceSamplerUpdate();
+    s_traceHeader.source = daemon_TraceSource();
+    
+    DebugLog("Trace: capturing");
+}
 
-    // Create our public port
-    s_PublicPort = CreateMsgPort();
-    if (!s_PublicPort)
+/**
+ * Stop recording, write the trace to TRACE_FILE_NAME, free the buffer.
+ */
+static void daemon_TraceStop(void)
+{
+    BPTR file;
+    
+    if (!s_trace) return;
+    
+    daemon_TraceSamplerStop();
+    
+    file = Open(TRACE_FILE_NAME, MODE_NEWFILE);
+    if (file)
     {
-        return FALSE;
+        Write(file, &s_traceHeader, sizeof(TraceHeader));
+        Write(file, s_trace, s_traceHeader.count * sizeof(TraceRecord));
+        Close(file);
     }
-    s_PublicPort->mp_Node.ln_Name = DAEMON_PORT_NAME;
-    s_PublicPort->mp_Node.ln_Pri = 0;
-    AddPort(s_PublicPort);
+    
+    DebugLogF("Trace: %ld records, %ld dropped -> %s", 
+              (LONG)s_traceHeader.count, (LONG)s_traceHeader.dropped,
+              file ? TRACE_FILE_NAME : "write failed");
+    
+    FreeMem(s_trace, TRACE_RECORDS_MAX * sizeof(TraceRecord));
+    s_trace = NULL;
+}
 
-    // Create input device for event injection    
-    s_InputPort = CreateMsgPort();
-    if (!s_InputPort)
+/**
+ * Apply a new extended options word.
+ * Leaving async injection waits for requests in flight, so slot 0
+ * is free again for DoIO. VBL sampling replaces the polling timer.
+ * @param options New OPT_* flags
+ */
+static inline void daemon_SetOptions(ULONG options)
+{
+    ULONG changed = s_options ^ options;
+    
+    if ((changed & OPT_ASYNC_INJECT) && !(options & OPT_ASYNC_INJECT))
     {
-        return FALSE;
+        injectDrain();
     }
-    s_InputReq = (struct IOStdReq *)CreateIORequest(s_InputPort, sizeof(struct IOStdReq));
-    if (!s_InputReq)
+    
+    // Leaving handler injection: splice what is queued, then remove the handler
+    if ((changed & OPT_HANDLER_INJECT) && !(options & OPT_HANDLER_INJECT))
     {
-        DeleteMsgPort(s_InputPort);
-        s_InputPort = NULL;
-        return FALSE;
+        injectHandlerStop();
     }
-    if (OpenDevice("input.device", 0, (struct IORequest *)s_InputReq, 0))
+    
+    s_options = options;
+    
+    if ((changed & OPT_HANDLER_INJECT) && (options & OPT_HANDLER_INJECT))
     {
-        DeleteIORequest((struct IORequest *)s_InputReq);
-        DeleteMsgPort(s_InputPort);
-        s_InputPort = NULL;
-        s_InputReq = NULL;
-        return FALSE;
+        injectHandlerStart();
     }
     
-    // Get InputBase from the opened device for PeekQualifier inline pragma
-    InputBase = s_InputReq->io_Device;
-
-    // Create Timer for polling
-    s_TimerPort = CreateMsgPort();
-    if (!s_TimerPort)
+    // Reopen timer.device on the new unit
+    if (changed & OPT_TIMER_UNIT_MASK)
     {
-        return FALSE;
+        if (!SAMPLING_EVENT_DRIVEN())
+        {
+            AbortIO((struct IORequest *)s_TimerReq);
+            WaitIO((struct IORequest *)s_TimerReq);
+        }
+        CloseDevice((struct IORequest *)s_TimerReq);
+        
+        if (!daemon_TimerOpen((UBYTE)((options & OPT_TIMER_UNIT_MASK) >> OPT_TIMER_UNIT_SHIFT)))
+        {
+            // Should not happen (VBLANK always available): stop daemon
+            Signal(FindTask(NULL), SIGBREAKF_CTRL_C);
+            return;
+        }
+        
+        if (!SAMPLING_EVENT_DRIVEN())
+        {
+            daemon_TimerStart(s_pollInterval);
+        }
     }
-    s_TimerReq = (struct timerequest *)CreateIORequest(s_TimerPort, sizeof(struct timerequest));
-    if (!s_TimerReq)
+    
+    // New button source: its current state is the baseline, not an edge
+    if (changed & OPT_SOURCE_XBTTS)
     {
-        DeleteMsgPort(s_TimerPort);
-        s_TimerPort = NULL;
-        return FALSE;
+        MouseSample sample;
+        
+        daemon_DecodeSample(HAL_ReadRegister(), &sample);
+        s_lastBTState = sample.buttons;
+        s_lastWHCounter = sample.wheel;
+        s_lastWHDelta = 0;
     }
-    if (OpenDevice(TIMERNAME, UNIT_VBLANK, (struct IORequest *)s_TimerReq, 0))
+    
+    // Switch between timer polling, VBL sampling and CIA sampling
+    // (restarted on a source change to reseed the interrupt's last sample)
+    if (changed & (OPT_VBL_SAMPLING | OPT_CIA_SAMPLING | OPT_CIA_RATE_MASK | OPT_SOURCE_XBTTS))
     {
-        DeleteIORequest((struct IORequest *)s_TimerReq);
-        DeleteMsgPort(s_TimerPort);
-        s_TimerPort = NULL;
-        s_TimerReq = NULL;
-        return FALSE;
+        BOOL wasEventDriven = SAMPLING_EVENT_DRIVEN();
+        
+        daemon_SamplingApply(options);
+        if (SAMPLING_EVENT_DRIVEN() && !wasEventDriven)
+        {
+            AbortIO((struct IORequest *)s_TimerReq);
+            WaitIO((struct IORequest *)s_TimerReq);
+        }
+        else if (!SAMPLING_EVENT_DRIVEN() && wasEventDriven)
+        {
+            daemon_TimerStart(s_pollInterval);
+        }
     }
-
-    // Initialize hardware state to avoid false initial events
-    s_lastBTState = SAGA_MOUSE_BUTTONS & (SAGA_BUTTON4_MASK | SAGA_BUTTON5_MASK);
-    s_lastWHCounter = SAGA_WHEELCOUNTER;
-    s_lastWHDelta = 0;
-    //s_lastWHDir = 0;
     
-    // Ensure config byte and poll interval are set
-    if (s_configByte == 0)
+    // Install or remove the pre-warm input handler
+    if (changed & OPT_PREWARM)
     {
-        s_configByte = DEFAULT_CONFIG_BYTE;
+        if (options & OPT_PREWARM)
+        {
+            daemon_PrewarmStart();
+        }
+        else
+        {
+            daemon_PrewarmStop();
+        }
     }
     
-    // Initialize adaptive polling system
-{
-        UBYTE modeIndex = ((s_configByte & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT) % 4;
-                
-        s_activeMode = &s_adaptiveModes[modeIndex];
-
-        // Check if normal mode (bit 6)
-        if (s_configByte & CONFIG_FIXED_MODE)
+    // Open or close the smoothing timer (pending detents sent at once)
+    if (changed & OPT_WHEEL_SMOOTH)
+    {
+        if (options & OPT_WHEEL_SMOOTH)
         {
-            // Normal mode: use burstUs constantly (no state machine)
-            s_adaptiveState = POLL_STATE_IDLE;  // State unused in normal mode
-            s_adaptiveInterval = s_activeMode->burstUs;
-            s_pollInterval = s_activeMode->burstUs;
+            daemon_SmoothStart();
         }
         else
         {
-            // Adaptive mode: start in IDLE
-            s_adaptiveState = POLL_STATE_IDLE;
-            s_adaptiveInterval = s_activeMode->idleUs;
-            s_pollInterval = s_activeMode->idleUs;
+            daemon_SmoothStop();
         }
-        
-        s_adaptiveInactive = 0;
     }
-
-    return TRUE;
+    
+    // Start capture, or stop and save it
+    if (changed & OPT_TRACE_CAPTURE)
+    {
+        if (options & OPT_TRACE_CAPTURE)
+        {
+            daemon_TraceStart();
+        }
+        else
+        {
+            daemon_TraceStop();
+        }
+    }
+    
+    DebugLogF("Injection: %s, wheel %s%s", 
+              (s_options & OPT_ASYNC_INJECT) ? "async" : "sync",
+              (s_options & OPT_WHEEL_COALESCE) ? "coalesced" : "per-detent",
+              (s_options & OPT_WHEEL_ACCEL) ? " + accel" : "");
 }
 
 /**
- * Cleanup daemon resources
+ * Load user profiles from PROFILE_FILE_NAME, one per line:
+ *   slot name idleUs activeUs burstUs stepDecUs stepIncUs activeThreshold idleThreshold curve
+ * Empty lines and lines starting with ';' or '#' are skipped, invalid
+ * lines are ignored. A missing file leaves the slots unchanged.
  */
-static inline void daemon_Cleanup(void)
+static void daemon_ProfileLoad(void)
 {
-
-#ifndef RELEASE
-    // Close debug console
-    if (s_debugCon)
+    UBYTE line[PROFILE_LINE_MAX];
+    struct XMouseProfile profile;
+    BPTR file = Open(PROFILE_FILE_NAME, MODE_OLDFILE);
+    
+    if (!file)
     {
-        Close(s_debugCon);
-        s_debugCon = 0;
+        return;
     }
-#endif
-
-    // Cleanup timer: abort pending request, close device, delete resources
-    if (s_TimerReq)
+    
+    while (FGets(file, (STRPTR)line, sizeof(line)))
     {
-        if (s_TimerReq->tr_node.io_Device)
+        UBYTE *p = line;
+        ULONG slot, curve;
+        UBYTE n = 0;
+        
+        while (*p == ' ' || *p == '\t')
         {
-            if (CheckIO((struct IORequest *)s_TimerReq) == NULL)
+            p++;
+        }
+        if (*p == ';' || *p == '#' || *p == '\n' || *p == '\0')
+        {
+            continue;
+        }
+        
+        slot = parseDecimal(&p);
+        
+        // Name: next word, truncated to PROFILE_NAME_MAX - 1
+        while (*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        while (*p > ' ')
+        {
+            if (n < PROFILE_NAME_MAX - 1)
             {
-                AbortIO((struct IORequest *)s_TimerReq);
-                WaitIO((struct IORequest *)s_TimerReq);
+                profile.name[n++] = (char)*p;
             }
-            CloseDevice((struct IORequest *)s_TimerReq);
+            p++;
         }
-        DeleteIORequest((struct IORequest *)s_TimerReq);
+        profile.name[n] = '\0';
+        
+        profile.idleUs = parseDecimal(&p);
+        profile.activeUs = parseDecimal(&p);
+        profile.burstUs = parseDecimal(&p);
+        profile.stepDecUs = parseDecimal(&p);
+        profile.stepIncUs = parseDecimal(&p);
+        profile.activeThreshold = parseDecimal(&p);
+        profile.idleThreshold = parseDecimal(&p);
+        curve = parseDecimal(&p);
+        
+        // parseDecimal() returns 0xFFFFFFFF for a missing field, intervals
+        // and steps are rejected by daemon_ProfileCheck()
+        if (n == 0 || slot >= PROFILE_USER_SLOTS || curve >= ACCEL_CURVE_COUNT ||
+            profile.activeThreshold == 0xFFFFFFFF || profile.idleThreshold == 0xFFFFFFFF)
+        {
+            continue;
+        }
+        profile.slot = (UBYTE)slot;
+        profile.accelCurve = (UBYTE)curve;
+        
+        daemon_ProfileSet(&profile);
     }
-    if (s_TimerPort)
+    
+    Close(file);
+}
+
+#endif // XMOUSED_HOST
+
+/**
+ * Profile of a config byte: built-in row or user slot (bit 3).
+ * @param configByte Configuration byte
+ * @return Profile selected by bits 4-5
+ */
+static inline const AdaptiveMode *daemon_ModeOf(UBYTE configByte)
+{
+    UBYTE modeIndex = ((configByte & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT) % 4;
+    
+    return (configByte & CONFIG_USER_PROFILE) ? &s_userModes[modeIndex] : &s_adaptiveModes[modeIndex];
+}
+
+/**
+ * Check a profile built at run time (same rules as ADAPTIVE_PROFILE_CHECK).
+ * The ladder builder would silently clamp too long ladders, they are
+ * rejected here instead.
+ * @param mode Profile to check
+ * @return TRUE if the profile can be used
+ */
+static inline BOOL daemon_ProfileCheck(const AdaptiveMode *mode)
+{
+    if (mode->burstUs == 0 || mode->burstUs >= mode->activeUs || mode->activeUs > mode->idleUs)
     {
-        DeleteMsgPort(s_TimerPort);
+        return FALSE;
     }
-
-    // cleanup input device
-    if (s_InputReq)
+    if (mode->idleUs >= 1000000 ||
+        mode->stepDecUs == 0 || mode->stepDecUs > mode->activeUs - mode->burstUs ||
+        mode->stepIncUs == 0 || mode->stepIncUs > mode->idleUs - mode->burstUs)
     {
-        if (s_InputReq->io_Device)
-        {
-            CloseDevice((struct IORequest *)s_InputReq);
-        }
-        DeleteIORequest((struct IORequest *)s_InputReq);
+        return FALSE;
     }
-    if (s_InputPort)
+    if (ADAPTIVE_LADDER_LEN(mode->activeUs, mode->burstUs, mode->stepDecUs) > ADAPTIVE_LADDER_MAX ||
+        ADAPTIVE_LADDER_LEN(mode->idleUs, mode->burstUs, mode->stepIncUs) > ADAPTIVE_LADDER_MAX)
     {
-        DeleteMsgPort(s_InputPort);
+        return FALSE;
     }
+    return mode->accelCurve < ACCEL_CURVE_COUNT;
+}
 
-    // cleanup public port
-    if (s_PublicPort)
+/**
+ * Store an uploaded profile in its user slot.
+ * The caller reapplies the mode if the slot is in use.
+ * @param profile Profile to copy (sender memory)
+ * @return FALSE if the slot or the parameters are invalid
+ */
+static BOOL daemon_ProfileSet(const struct XMouseProfile *profile)
+{
+    AdaptiveMode mode;
+    char *name;
+    UBYTE i;
+    
+    if (profile->slot >= PROFILE_USER_SLOTS)
     {
-        RemPort(s_PublicPort);
-        DeleteMsgPort(s_PublicPort);
+        return FALSE;
+    }
+    
+    mode.idleUs = profile->idleUs;
+    mode.activeUs = profile->activeUs;
+    mode.burstUs = profile->burstUs;
+    mode.stepDecUs = profile->stepDecUs;
+    mode.stepIncUs = profile->stepIncUs;
+    mode.activeThreshold = profile->activeThreshold;
+    mode.idleThreshold = profile->idleThreshold;
+    mode.accelCurve = profile->accelCurve;
+    
+    if (!daemon_ProfileCheck(&mode))
+    {
+        return FALSE;
+    }
+    
+    // Same name for the adaptive and the fixed variant
+    name = s_userNames[profile->slot];
+    for (i = 0; i < PROFILE_NAME_MAX - 1 && profile->name[i]; i++)
+    {
+        name[i] = profile->name[i];
     }
+    name[i] = '\0';
+    mode.adaptiveName = name;
+    mode.normalName = name;
+    
+    s_userModes[profile->slot] = mode;
+    return TRUE;
+}
 
-    // cleanup DOS library
-    if (DOSBase)
+/**
+ * Select the polling profile from the config byte and reset its state.
+ * Fixed mode polls at burstUs, adaptive mode starts in IDLE.
+ */
+static inline void daemon_ApplyMode(void)
+{
+    s_activeMode = daemon_ModeOf(s_configByte);
+    s_adaptiveState = POLL_STATE_IDLE;
+    daemon_LadderBuild(s_activeMode);
+    
+    // Check if normal mode (bit 6)
+    if (s_configByte & CONFIG_FIXED_MODE)
     {
-        CloseLibrary((struct Library *)DOSBase);
+        // Normal mode: use burstUs constantly (no state machine)
+        s_adaptiveInterval = s_activeMode->burstUs;
+    }
+    else
+    {
+        // Adaptive mode: start in IDLE
+        s_adaptiveInterval = s_activeMode->idleUs;
+        s_adaptiveStep = s_ladderIncLast;
     }
+    
+    s_pollInterval = s_adaptiveInterval;
+    s_adaptiveInactive = 0;
+    s_predictGap = s_activeMode->activeUs;
+    s_predictDev = s_activeMode->activeUs >> 1;
+    s_predictElapsed = 0;
+    daemon_TickSelect();
 }
 
 /**
@@ -1335,8 +6395,7 @@ static inline void daemon_Cleanup(void)
  */
 static inline const char* getModeName(UBYTE configByte)
 {
-    UBYTE modeIndex = ((configByte & CONFIG_INTERVAL_MASK) >> CONFIG_INTERVAL_SHIFT) % 4;
-    const AdaptiveMode *mode = &s_adaptiveModes[modeIndex];
+    const AdaptiveMode *mode = daemon_ModeOf(configByte);
     
     return (configByte & CONFIG_FIXED_MODE) ? mode->normalName : mode->adaptiveName;
 }
@@ -1362,3 +6421,30 @@ static inline int parseHexDigit(UBYTE c)
     }
     return -1;
 }
+
+/**
+ * Parse a decimal number, skipping leading spaces.
+ * @param p Parse position, moved past the number
+ * @return Value, 0xFFFFFFFF if no digit
+ */
+static inline ULONG parseDecimal(UBYTE **p)
+{
+    UBYTE *q = *p;
+    ULONG value = 0;
+    
+    while (*q == ' ' || *q == '\t')
+    {
+        q++;
+    }
+    if (*q < '0' || *q > '9')
+    {
+        *p = q;
+        return 0xFFFFFFFF;
+    }
+    while (*q >= '0' && *q <= '9')
+    {
+        value = value * 10 + (*q++ - '0');
+    }
+    *p = q;
+    return value;
+}